@@ -0,0 +1,444 @@
+#pragma once
+
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+
+#include "circvector.h"
+
+using namespace std;
+
+// Coroutine queue on top of `CircVector`. Consumers `co_await q.pop()` and
+// sleep until an element arrives; producers `co_await q.push(elem)` and
+// sleep while a bounded queue is full. Nothing polls: a push hands its
+// element straight to the oldest waiting consumer, and a pop moves the
+// oldest waiting producer's element in, so a woken coroutine never finds
+// the queue empty (or full) again.
+//
+// Woken coroutines are never resumed inline. They are posted to an
+// executor, which resumes them once the waking coroutine suspends or
+// returns. A push of many elements therefore wakes at most one consumer per
+// element, all in one batch, without nesting resumptions on the producer's
+// stack. Everything here is single-threaded: the queue, its waiters and the
+// executor must all run on one thread.
+
+/**
+ * Coroutine that starts suspended and runs when an executor resumes it,
+ * e.g. after `ManualExecutor::spawn`. Owns its frame: destroying the `Task`
+ * destroys the coroutine, so it must outlive any executor queue it is
+ * posted to.
+ */
+class Task {
+ public:
+  struct promise_type {
+    exception_ptr error;
+
+    Task get_return_object() {
+      return Task(coroutine_handle<promise_type>::from_promise(*this));
+    }
+
+    suspend_always initial_suspend() noexcept {
+      return {};
+    }
+
+    suspend_always final_suspend() noexcept {
+      return {};
+    }
+
+    void return_void() {
+    }
+
+    void unhandled_exception() {
+      this->error = current_exception();
+    }
+  };
+
+ private:
+  coroutine_handle<promise_type> handle;
+
+  explicit Task(coroutine_handle<promise_type> handle) : handle(handle) {
+  }
+
+ public:
+  Task(Task &&other) noexcept : handle(exchange(other.handle, nullptr)) {
+  }
+
+  Task &operator=(Task &&other) noexcept {
+    if (this != &other) {
+      if (this->handle) {
+        this->handle.destroy();
+      }
+      this->handle = exchange(other.handle, nullptr);
+    }
+    return *this;
+  }
+
+  Task(const Task &) = delete;
+  Task &operator=(const Task &) = delete;
+
+  ~Task() {
+    if (this->handle) {
+      this->handle.destroy();
+    }
+  }
+
+  /**
+   * Returns whether the coroutine has run to completion.
+   */
+  bool done() const {
+    return this->handle.done();
+  }
+
+  /**
+   * Rethrows the exception the coroutine exited with, if any.
+   *
+   * If the coroutine has not completed, throws a `runtime_error`.
+   */
+  void get() const {
+    if (!this->handle.done()) {
+      throw runtime_error("task has not completed");
+    }
+    if (this->handle.promise().error) {
+      rethrow_exception(this->handle.promise().error);
+    }
+  }
+
+  /**
+   * Returns the handle that resumes the coroutine.
+   */
+  coroutine_handle<> get_handle() const {
+    return this->handle;
+  }
+};
+
+/**
+ * Minimal single-threaded executor: a FIFO of coroutines ready to resume,
+ * drained by `run()` on the calling thread. Any executor with a
+ * `post(coroutine_handle<>)` member works with `AsyncQueue`.
+ */
+class ManualExecutor {
+ private:
+  CircVector<coroutine_handle<>> ready;
+
+ public:
+  /**
+   * Queues `handle` to be resumed by `run()`.
+   */
+  void post(coroutine_handle<> handle) {
+    this->ready.push_back(handle);
+  }
+
+  /**
+   * Queues the given `Task` to start.
+   */
+  void spawn(const Task &task) {
+    post(task.get_handle());
+  }
+
+  /**
+   * Returns the number of coroutines waiting to be resumed.
+   */
+  size_t pending() const {
+    return this->ready.size();
+  }
+
+  /**
+   * Resumes the oldest ready coroutine. Returns false if there was none.
+   */
+  bool run_one() {
+    if (this->ready.empty()) {
+      return false;
+    }
+    this->ready.pop_front().resume();
+    return true;
+  }
+
+  /**
+   * Resumes ready coroutines, including ones they make ready, until none
+   * is left. Returns how many it resumed.
+   */
+  size_t run() {
+    size_t resumed = 0;
+    while (run_one()) {
+      resumed++;
+    }
+    return resumed;
+  }
+};
+
+/**
+ * FIFO queue of `T` whose consumers and producers can wait with
+ * `co_await`. Holds at most `capacity` elements; `push` waits and the
+ * `try_push` functions fail while it is full. Waiting consumers and
+ * producers are served oldest first, and woken through `Executor::post`.
+ *
+ * The queue must outlive the executor's queue of coroutines it woke.
+ * Destroying a coroutine while it waits in `pop()` or `push()` withdraws it;
+ * destroying the queue while coroutines wait leaves them suspended.
+ */
+template <typename T, typename Executor = ManualExecutor>
+class AsyncQueue {
+ public:
+  class PopAwaiter;
+  class PushAwaiter;
+
+ private:
+  Executor &executor;
+  size_t capacity;
+  CircVector<T> items;
+
+  // Suspended awaiters, oldest first. At most one of the two is non-empty:
+  // consumers only wait on an empty queue, producers on a full one.
+  CircVector<PopAwaiter *> consumers;
+  CircVector<PushAwaiter *> producers;
+
+  // Hands `elem` to the oldest waiting consumer, or else appends it if
+  // there is room. Returns false, leaving `elem` alone, if neither.
+  template <typename U>
+  bool offer(U &&elem) {
+    if (!this->consumers.empty()) {
+      PopAwaiter *consumer = this->consumers.front();
+      consumer->value.emplace(forward<U>(elem));
+      this->consumers.pop_front();
+      consumer->waiting = false;
+      this->executor.post(consumer->handle);
+      return true;
+    }
+    if (this->items.size() < this->capacity) {
+      this->items.push_back(forward<U>(elem));
+      return true;
+    }
+    return false;
+  }
+
+  // Takes the oldest element, then lets the oldest waiting producer fill
+  // the slot it freed.
+  T take() {
+    T elem = this->items.pop_front();
+    if (!this->producers.empty()) {
+      PushAwaiter *producer = this->producers.front();
+      this->items.push_back(move(producer->elem));
+      this->producers.pop_front();
+      producer->waiting = false;
+      this->executor.post(producer->handle);
+    }
+    return elem;
+  }
+
+  // Removes a waiter whose coroutine is being destroyed.
+  template <typename Awaiter>
+  static void withdraw(CircVector<Awaiter *> &waiters, Awaiter *waiter) {
+    size_t idx = waiters.find(waiter);
+    if (idx != static_cast<size_t>(-1)) {
+      waiters.remove_at(idx);
+    }
+  }
+
+ public:
+  /**
+   * Awaitable returned by `pop()`. Resumes with the oldest element.
+   */
+  class PopAwaiter {
+   private:
+    friend class AsyncQueue;
+
+    AsyncQueue *queue;
+    bool waiting;  // Suspended in `consumers`
+    optional<T> value;
+    coroutine_handle<> handle;
+
+   public:
+    explicit PopAwaiter(AsyncQueue *queue) : queue(queue), waiting(false) {
+    }
+
+    PopAwaiter(const PopAwaiter &) = delete;
+    PopAwaiter &operator=(const PopAwaiter &) = delete;
+
+    ~PopAwaiter() {
+      if (this->waiting) {
+        withdraw(this->queue->consumers, this);
+      }
+    }
+
+    bool await_ready() {
+      if (this->queue->items.empty()) {
+        return false;
+      }
+      this->value.emplace(this->queue->take());
+      return true;
+    }
+
+    void await_suspend(coroutine_handle<> handle) {
+      this->handle = handle;
+      this->queue->consumers.push_back(this);
+      this->waiting = true;
+    }
+
+    T await_resume() {
+      return move(*this->value);
+    }
+  };
+
+  /**
+   * Awaitable returned by `push()`. Resumes once the element is queued or
+   * handed to a consumer.
+   */
+  class PushAwaiter {
+   private:
+    friend class AsyncQueue;
+
+    AsyncQueue *queue;
+    bool waiting;  // Suspended in `producers`
+    T elem;
+    coroutine_handle<> handle;
+
+   public:
+    PushAwaiter(AsyncQueue *queue, T &&elem)
+        : queue(queue), waiting(false), elem(move(elem)) {
+    }
+
+    PushAwaiter(const PushAwaiter &) = delete;
+    PushAwaiter &operator=(const PushAwaiter &) = delete;
+
+    ~PushAwaiter() {
+      if (this->waiting) {
+        withdraw(this->queue->producers, this);
+      }
+    }
+
+    bool await_ready() {
+      return this->queue->offer(move(this->elem));
+    }
+
+    void await_suspend(coroutine_handle<> handle) {
+      this->handle = handle;
+      this->queue->producers.push_back(this);
+      this->waiting = true;
+    }
+
+    void await_resume() {
+    }
+  };
+
+  /**
+   * Creates an empty queue holding at most `capacity` elements, waking
+   * coroutines through `executor`. Capacity must exceed 0.
+   */
+  explicit AsyncQueue(Executor &executor,
+                      size_t capacity = static_cast<size_t>(-1))
+      : executor(executor), capacity(capacity) {
+    if (capacity == 0) {
+      throw out_of_range("invalid capacity. must exceed zero");
+    }
+  }
+
+  AsyncQueue(const AsyncQueue &) = delete;
+  AsyncQueue &operator=(const AsyncQueue &) = delete;
+
+  /**
+   * Destructor. Coroutines still waiting stay suspended.
+   */
+  ~AsyncQueue() {
+    while (!this->consumers.empty()) {
+      this->consumers.pop_front()->waiting = false;
+    }
+    while (!this->producers.empty()) {
+      this->producers.pop_front()->waiting = false;
+    }
+  }
+
+  /**
+   * Returns the number of queued elements.
+   */
+  size_t size() const {
+    return this->items.size();
+  }
+
+  /**
+   * Returns whether no element is queued.
+   */
+  bool empty() const {
+    return this->items.empty();
+  }
+
+  /**
+   * Returns the most elements the queue holds.
+   */
+  size_t get_capacity() const {
+    return this->capacity;
+  }
+
+  /**
+   * Returns the number of coroutines waiting in `pop()`.
+   */
+  size_t waiting_consumers() const {
+    return this->consumers.size();
+  }
+
+  /**
+   * Returns the number of coroutines waiting in `push()`.
+   */
+  size_t waiting_producers() const {
+    return this->producers.size();
+  }
+
+  /**
+   * Returns an awaitable that removes the oldest element and resumes with
+   * it, suspending while the queue is empty.
+   */
+  PopAwaiter pop() {
+    return PopAwaiter(this);
+  }
+
+  /**
+   * Returns an awaitable that adds the given `T` to the back, suspending
+   * while the queue is full. If a consumer is waiting, hands it the element
+   * directly.
+   */
+  PushAwaiter push(T elem) {
+    return PushAwaiter(this, move(elem));
+  }
+
+  /**
+   * Adds the given `T` to the back without waiting. If a consumer is
+   * waiting, hands it the element directly and posts it to the executor.
+   * Returns false if the queue is full.
+   */
+  bool try_push(const T &elem) {
+    return offer(elem);
+  }
+
+  bool try_push(T &&elem) {
+    return offer(move(elem));
+  }
+
+  /**
+   * Copies up to `count` elements from `src` to the back without waiting,
+   * waking one waiting consumer per element for as long as there are any.
+   * Returns how many were pushed, which is less than `count` if the queue
+   * filled up.
+   */
+  size_t try_push_n(const T *src, size_t count) {
+    size_t pushed = 0;
+    for (; pushed < count; pushed++) {
+      if (!try_push(src[pushed])) {
+        break;
+      }
+    }
+    return pushed;
+  }
+
+  /**
+   * Removes the oldest element without waiting, or returns an empty
+   * `optional` if there is none.
+   */
+  optional<T> try_pop() {
+    if (this->items.empty()) {
+      return nullopt;
+    }
+    return take();
+  }
+};
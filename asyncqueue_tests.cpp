@@ -0,0 +1,233 @@
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "asyncqueue.h"
+
+using namespace std;
+using namespace testing;
+
+// Coroutines take their state by reference, so it lives in the test body
+// rather than in a lambda that could die before the coroutine does.
+
+Task consume(AsyncQueue<int> &queue, vector<int> &out, size_t count) {
+  for (size_t i = 0; i < count; i++) {
+    out.push_back(co_await queue.pop());
+  }
+}
+
+Task produce(AsyncQueue<int> &queue, int first, int count) {
+  for (int i = first; i < first + count; i++) {
+    co_await queue.push(i);
+  }
+}
+
+Task consume_strings(AsyncQueue<string> &queue, string &out, size_t count) {
+  for (size_t i = 0; i < count; i++) {
+    out += co_await queue.pop();
+  }
+}
+
+Task consume_then_throw(AsyncQueue<int> &queue) {
+  co_await queue.pop();
+  throw runtime_error("consumer failed");
+}
+
+TEST(AsyncQueueCore, try_push_try_pop) {
+  ManualExecutor executor;
+  AsyncQueue<int> queue(executor, 2);
+
+  EXPECT_THAT(queue.try_pop(), Eq(nullopt));
+  EXPECT_THAT(queue.try_push(1), Eq(true));
+  EXPECT_THAT(queue.try_push(2), Eq(true));
+  EXPECT_THAT(queue.try_push(3), Eq(false));
+  EXPECT_THAT(queue.size(), Eq(2));
+  EXPECT_THAT(queue.try_pop(), Optional(1));
+  EXPECT_THAT(queue.try_pop(), Optional(2));
+  EXPECT_THAT(queue.empty(), Eq(true));
+  EXPECT_THAT(executor.pending(), Eq(0));
+}
+
+TEST(AsyncQueueCore, zero_capacity_throws) {
+  ManualExecutor executor;
+
+  EXPECT_THROW((AsyncQueue<int>(executor, 0)), out_of_range);
+}
+
+TEST(AsyncQueueCore, try_push_n_stops_when_full) {
+  ManualExecutor executor;
+  AsyncQueue<int> queue(executor, 3);
+  int src[] = {1, 2, 3, 4, 5};
+
+  EXPECT_THAT(queue.try_push_n(src, 5), Eq(3));
+  EXPECT_THAT(queue.try_pop(), Optional(1));
+  EXPECT_THAT(queue.try_push_n(src + 3, 2), Eq(1));
+  EXPECT_THAT(queue.try_pop(), Optional(2));
+  EXPECT_THAT(queue.try_pop(), Optional(3));
+  EXPECT_THAT(queue.try_pop(), Optional(4));
+}
+
+TEST(AsyncQueueCoroutines, consumer_waits_for_push) {
+  ManualExecutor executor;
+  AsyncQueue<int> queue(executor);
+  vector<int> out;
+  Task consumer = consume(queue, out, 1);
+
+  executor.spawn(consumer);
+  EXPECT_THAT(executor.run(), Eq(1));
+  EXPECT_THAT(queue.waiting_consumers(), Eq(1));
+  EXPECT_THAT(consumer.done(), Eq(false));
+
+  // The element goes straight to the consumer, which is posted rather than
+  // resumed inside the push.
+  EXPECT_THAT(queue.try_push(7), Eq(true));
+  EXPECT_THAT(queue.empty(), Eq(true));
+  EXPECT_THAT(queue.waiting_consumers(), Eq(0));
+  EXPECT_THAT(out, IsEmpty());
+  EXPECT_THAT(executor.pending(), Eq(1));
+
+  executor.run();
+  EXPECT_THAT(out, ElementsAre(7));
+  EXPECT_THAT(consumer.done(), Eq(true));
+}
+
+TEST(AsyncQueueCoroutines, producer_waits_when_full) {
+  ManualExecutor executor;
+  AsyncQueue<int> queue(executor, 2);
+  Task producer = produce(queue, 0, 4);
+
+  executor.spawn(producer);
+  executor.run();
+  EXPECT_THAT(queue.size(), Eq(2));
+  EXPECT_THAT(queue.waiting_producers(), Eq(1));
+
+  // The pop lets the waiting producer's element in right away.
+  EXPECT_THAT(queue.try_pop(), Optional(0));
+  EXPECT_THAT(queue.size(), Eq(2));
+  EXPECT_THAT(queue.waiting_producers(), Eq(0));
+  executor.run();
+  EXPECT_THAT(queue.waiting_producers(), Eq(1));
+
+  EXPECT_THAT(queue.try_pop(), Optional(1));
+  executor.run();
+  EXPECT_THAT(producer.done(), Eq(true));
+  EXPECT_THAT(queue.try_pop(), Optional(2));
+  EXPECT_THAT(queue.try_pop(), Optional(3));
+}
+
+TEST(AsyncQueueCoroutines, batched_wakeups) {
+  ManualExecutor executor;
+  AsyncQueue<int> queue(executor);
+  vector<int> out;
+  vector<Task> consumers;
+  for (int i = 0; i < 3; i++) {
+    consumers.push_back(consume(queue, out, 1));
+    executor.spawn(consumers.back());
+  }
+  executor.run();
+  EXPECT_THAT(queue.waiting_consumers(), Eq(3));
+
+  // One consumer woken per element while any wait, none resumed inline;
+  // the rest of the batch is queued.
+  int src[] = {10, 11, 12, 13, 14};
+  EXPECT_THAT(queue.try_push_n(src, 5), Eq(5));
+  EXPECT_THAT(executor.pending(), Eq(3));
+  EXPECT_THAT(out, IsEmpty());
+  EXPECT_THAT(queue.size(), Eq(2));
+
+  EXPECT_THAT(executor.run(), Eq(3));
+  EXPECT_THAT(out, ElementsAre(10, 11, 12));
+  EXPECT_THAT(queue.try_pop(), Optional(13));
+}
+
+TEST(AsyncQueueCoroutines, pipeline_keeps_order) {
+  ManualExecutor executor;
+  AsyncQueue<int> queue(executor, 4);
+  vector<int> out;
+  Task consumer = consume(queue, out, 2000);
+  Task first = produce(queue, 0, 1000);
+  Task second = produce(queue, 1000, 1000);
+
+  executor.spawn(consumer);
+  executor.spawn(first);
+  executor.spawn(second);
+  executor.run();
+
+  EXPECT_THAT(consumer.done(), Eq(true));
+  EXPECT_THAT(first.done(), Eq(true));
+  EXPECT_THAT(second.done(), Eq(true));
+  ASSERT_THAT(out.size(), Eq(2000));
+  // Each producer's elements arrive in the order it pushed them.
+  int next_first = 0;
+  int next_second = 1000;
+  for (int elem : out) {
+    if (elem < 1000) {
+      EXPECT_THAT(elem, Eq(next_first++));
+    } else {
+      EXPECT_THAT(elem, Eq(next_second++));
+    }
+  }
+}
+
+TEST(AsyncQueueCoroutines, non_trivial_elements) {
+  ManualExecutor executor;
+  AsyncQueue<string> queue(executor, 1);
+  string out;
+  Task consumer = consume_strings(queue, out, 3);
+
+  executor.spawn(consumer);
+  executor.run();
+  EXPECT_THAT(queue.try_push("a string too long for SSO, part one "),
+              Eq(true));
+  EXPECT_THAT(queue.try_push("two "), Eq(true));
+  EXPECT_THAT(queue.try_push("three"), Eq(false));
+  executor.run();
+  EXPECT_THAT(queue.try_push("three"), Eq(true));
+  executor.run();
+  EXPECT_THAT(out, StrEq("a string too long for SSO, part one two three"));
+}
+
+TEST(AsyncQueueCoroutines, destroyed_waiter_withdraws) {
+  ManualExecutor executor;
+  AsyncQueue<int> queue(executor, 1);
+  vector<int> out;
+  {
+    Task consumer = consume(queue, out, 1);
+    executor.spawn(consumer);
+    executor.run();
+    EXPECT_THAT(queue.waiting_consumers(), Eq(1));
+  }
+  EXPECT_THAT(queue.waiting_consumers(), Eq(0));
+
+  queue.try_push(1);
+  {
+    Task producer = produce(queue, 2, 1);
+    executor.spawn(producer);
+    executor.run();
+    EXPECT_THAT(queue.waiting_producers(), Eq(1));
+  }
+  EXPECT_THAT(queue.waiting_producers(), Eq(0));
+
+  EXPECT_THAT(queue.try_pop(), Optional(1));
+  EXPECT_THAT(queue.empty(), Eq(true));
+  EXPECT_THAT(executor.pending(), Eq(0));
+  EXPECT_THAT(out, IsEmpty());
+}
+
+TEST(AsyncQueueCoroutines, task_reports_exception) {
+  ManualExecutor executor;
+  AsyncQueue<int> queue(executor);
+  Task consumer = consume_then_throw(queue);
+
+  executor.spawn(consumer);
+  executor.run();
+  EXPECT_THROW(consumer.get(), runtime_error);  // not done yet
+  queue.try_push(1);
+  executor.run();
+  EXPECT_THAT(consumer.done(), Eq(true));
+  EXPECT_THROW(consumer.get(), runtime_error);
+}
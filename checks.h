@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+
+using namespace std;
+
+// Whether the unchecked accessors (`operator[]`, `front()`, `back()`) verify
+// their preconditions. Defaults to on unless `NDEBUG` is defined, so debug
+// builds catch misuse and release builds compile the checks out. Define
+// `LIST_CHECKED_ACCESS` to 0 or 1 to choose explicitly; every translation
+// unit of a program must agree.
+#ifndef LIST_CHECKED_ACCESS
+#ifdef NDEBUG
+#define LIST_CHECKED_ACCESS 0
+#else
+#define LIST_CHECKED_ACCESS 1
+#endif
+#endif
+
+inline constexpr bool checked_access = LIST_CHECKED_ACCESS;
+
+/**
+ * Aborts with a message naming `what` if `condition` is false and checked
+ * access is on. With checked access off, compiles to nothing.
+ *
+ * Aborts rather than throws, so the accessors it guards can be `noexcept`.
+ */
+inline void expects(bool condition, const char *what) noexcept {
+  if constexpr (checked_access) {
+    if (!condition) {
+      fprintf(stderr, "precondition violated: %s\n", what);
+      abort();
+    }
+  }
+}
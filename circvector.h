@@ -1,150 +1,1052 @@
 #pragma once
 
+#include <algorithm>
+#include <bit>
+#include <compare>
+#include <concepts>
+#include <cstddef>
+#include <cstring>
 #include <iostream>
+#include <iterator>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+#include <span>
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <type_traits>
+#include <utility>
+
+#include "checks.h"
+#include "serialization.h"
+#include "simdscan.h"
+#include "stats.h"
 
 using namespace std;
 
 //*************FOR O(1) TIME COMPLEXITY, THERE HAS TO BE DIRECT INSERTION INTO
 // THE ARRAY, NO LOOPING************//
 
+/**
+ * Capacity policy that keeps capacities exactly as requested. Wrapping an
+ * index costs an integer division.
+ */
+struct ExactCapacity {
+  static constexpr size_t round(size_t capacity) {
+    return capacity;
+  }
+
+  static constexpr size_t wrap(size_t index, size_t capacity) {
+    return index % capacity;
+  }
+};
+
+/**
+ * Capacity policy that rounds every capacity up to a power of two, so that
+ * wrapping an index is a single bitmask instead of a division.
+ */
+struct PowerOfTwoCapacity {
+  static constexpr size_t round(size_t capacity) {
+    return bit_ceil(capacity);
+  }
+
+  static constexpr size_t wrap(size_t index, size_t capacity) {
+    return index & (capacity - 1);
+  }
+};
+
+/**
+ * Growth policy that doubles the capacity of a full `CircVector`. Pushes are
+ * amortized O(1); up to half the buffer may sit unused.
+ */
+struct DoublingGrowth {
+  static size_t grow(size_t capacity) {
+    return capacity * 2;
+  }
+};
+
+/**
+ * Growth policy that grows a full `CircVector` by half. Pushes are still
+ * amortized O(1), with more reallocations than doubling but at most a third
+ * of the buffer unused. (`PowerOfTwoCapacity` rounds this back up to
+ * doubling.)
+ */
+struct HalfAgainGrowth {
+  static size_t grow(size_t capacity) {
+    return capacity + max<size_t>(capacity / 2, 1);
+  }
+};
+
+/**
+ * Growth policy that adds `Step` slots to a full `CircVector`. Keeps the
+ * slack bounded, but pushes cost O(N / Step) amortized, so it only suits
+ * rings whose size is roughly known, or allocators that grow in place (see
+ * `HugePageAllocator::reallocate`).
+ */
+template <size_t Step>
+struct FixedGrowth {
+  static_assert(Step > 0, "growth step must exceed zero");
+
+  static size_t grow(size_t capacity) {
+    return capacity + Step;
+  }
+};
+
+/**
+ * Growth policy for a fixed-capacity ring, such as a "last N samples"
+ * window: a full `CircVector` never grows. Instead, `push_back` overwrites
+ * the oldest element (the front) and `push_front` the newest (the back), in
+ * O(1) and without allocating; `append`/`prepend` behave as the same
+ * sequence of single pushes. `get_overwritten()` counts the elements lost
+ * this way. Inserting in the middle of a full ring throws `length_error`.
+ */
+struct OverwriteOnFull {
+  static constexpr bool overwrite_on_full = true;
+};
+
+/**
+ * Marks `T` as trivially relocatable: moving an object to a new address and
+ * forgetting the old one is equivalent to copying its bytes. Every trivially
+ * copyable type qualifies; specialize this to `true_type` for other types
+ * (e.g. ones owning a `unique_ptr`) to let `CircVector` grow with `memcpy`.
+ */
+template <typename T>
+struct is_trivially_relocatable : bool_constant<is_trivially_copyable_v<T>> {};
+
+/**
+ * Uninitialized storage for `N` elements of type `T` inside an object. Empty
+ * when `N` is 0.
+ */
+template <typename T, size_t N>
+struct InlineBuffer {
+  alignas(T) unsigned char bytes[N * sizeof(T)];
+
+  T *get() {
+    return reinterpret_cast<T *>(this->bytes);
+  }
+
+  const T *get() const {
+    return reinterpret_cast<const T *>(this->bytes);
+  }
+};
+
 template <typename T>
+struct InlineBuffer<T, 0> {
+  T *get() {
+    return nullptr;
+  }
+
+  const T *get() const {
+    return nullptr;
+  }
+};
+
+/**
+ * Ring buffer of `T`. `InlineCapacity` slots live inside the object itself:
+ * while the capacity fits there, the `CircVector` never touches the
+ * allocator (see `SmallCircVector`). `Stats` is the instrumentation policy
+ * (see `stats.h`); the default records nothing.
+ */
+template <typename T, typename CapacityPolicy = ExactCapacity,
+          typename Allocator = allocator<T>,
+          typename GrowthPolicy = DoublingGrowth, size_t InlineCapacity = 0,
+          typename Stats = NoStats>
 class CircVector {
+  static_assert(InlineCapacity == 0 ||
+                    CapacityPolicy::round(InlineCapacity) == InlineCapacity,
+                "inline capacity must be one the capacity policy allows");
+
  private:
-  T *data;           // The array of T data
+  using alloc_traits = allocator_traits<Allocator>;
+
+  static constexpr bool overwrites = requires {
+    requires GrowthPolicy::overwrite_on_full;
+  };
+
+  // Whether the buffer can grow through `Allocator::reallocate`, which keeps
+  // the bytes and may move whole pages instead of copying them, for the
+  // sizes `Allocator::is_mapped` accepts, and reports whether it copied
+  // them after all. The elements must survive being moved as bytes.
+  static constexpr bool remappable =
+      is_trivially_relocatable<T>::value &&
+      requires(Allocator &alloc, T *ptr, size_t count, bool *copied) {
+        { alloc.is_mapped(count) } -> same_as<bool>;
+        { alloc.reallocate(ptr, count, count, copied) } -> same_as<T *>;
+      };
+
+  T *data;           // The array of T data, possibly `inline_buffer`
   size_t vec_size;   // size of array
   size_t capacity;   // Capacity of array
   size_t front_idx;  // index of front of the array
+  [[no_unique_address]] Allocator alloc;
+  [[no_unique_address]] InlineBuffer<T, InlineCapacity> inline_buffer;
 
-  int wrap(size_t index, int difference) const {
-    int indx = (this->capacity + index + difference) % this->capacity;
-    return indx;
+  // Not copied or moved with the elements: every `CircVector` reports on
+  // itself. Mutable so that const accessors can be timed.
+  [[no_unique_address]] mutable Stats stats;
+
+  // Auto-shrink: halve the capacity while occupancy is below `shrink_below`
+  // (0 disables it), but never below `min_capacity`.
+  double shrink_below;
+  size_t min_capacity;
+
+  // Elements dropped by pushes onto a full ring (`OverwriteOnFull` only).
+  size_t overwritten;
+
+  // Maps `index + difference` onto the ring. Both operands are below
+  // `capacity`, so the sum cannot overflow for any ring that fits in memory.
+  size_t wrap(size_t index, size_t difference) const {
+    return CapacityPolicy::wrap(index + difference, this->capacity);
+  }
+
+  // The storage slot of the element at logical `index`, which need not be
+  // live yet (used to construct into the slot just past the back).
+  T &slot(size_t index) const {
+    return this->data[wrap(this->front_idx, index)];
+  }
+
+  // Steps an index back by one slot without going through unsigned underflow
+  // of `index - 1`, which a non-power-of-two modulo would not undo.
+  size_t wrap_back(size_t index) const {
+    return index == 0 ? this->capacity - 1 : index - 1;
+  }
+
+  // Whether the elements live in `inline_buffer`.
+  bool is_inline() const {
+    return InlineCapacity > 0 && this->data == this->inline_buffer.get();
+  }
+
+  // The capacity of a buffer for `count` elements: the whole inline buffer
+  // whenever they fit in it, so a ring only leaves it once it outgrows it.
+  static size_t buffer_capacity(size_t count) {
+    if constexpr (InlineCapacity > 0) {
+      if (count <= InlineCapacity) {
+        return InlineCapacity;
+      }
+    }
+    return count;
+  }
+
+  // Returns uninitialized storage for `count` elements. Slots only hold a
+  // live `T` between a push and the matching pop/clear. Hands out the
+  // inline buffer when `count` fits and it is not the current buffer, so
+  // `data` must be initialized (or nullptr) before calling this. Callers
+  // size inline requests with `buffer_capacity`.
+  T *allocate(size_t count) {
+    this->stats.on_capacity(count);
+    if constexpr (InlineCapacity > 0) {
+      if (count <= InlineCapacity && !is_inline()) {
+        return this->inline_buffer.get();
+      }
+    }
+    return alloc_traits::allocate(this->alloc, count);
+  }
+
+  void deallocate(T *ptr, size_t count) {
+    if (ptr != nullptr && ptr != this->inline_buffer.get()) {
+      alloc_traits::deallocate(this->alloc, ptr, count);
+    }
+  }
+
+  // Moves the elements of `other`, whose buffer is inline and so cannot
+  // change hands, into this vector's own (empty) inline buffer. `other` is
+  // left empty, keeping its inline buffer.
+  void take_inline(CircVector &other) {
+    this->data = this->inline_buffer.get();
+    this->capacity = other.capacity;
+    this->front_idx = 0;
+    this->vec_size = 0;
+    other.relocate_into(this->data);
+    this->vec_size = other.vec_size;
+    other.vec_size = 0;
+    other.front_idx = 0;
+  }
+
+  // Elements are built and torn down through the allocator, so that e.g. a
+  // `polymorphic_allocator` hands its memory resource on to `pmr::string`
+  // elements. Trivially copyable elements are still copied with memcpy.
+  template <typename... Args>
+  void construct(T *ptr, Args &&...args) {
+    alloc_traits::construct(this->alloc, ptr, forward<Args>(args)...);
+  }
+
+  void destroy_elem(T *ptr) {
+    alloc_traits::destroy(this->alloc, ptr);
+  }
+
+  void destroy_range(T *first, size_t count) {
+    if constexpr (!is_trivially_destructible_v<T>) {
+      for (size_t i = 0; i < count; i++) {
+        destroy_elem(first + i);
+      }
+    }
+  }
+
+  // Copy-constructs `src[0, count)` into the uninitialized `dest`. If a copy
+  // throws, destroys the ones already made and rethrows.
+  void construct_copies(const T *src, size_t count, T *dest) {
+    size_t i = 0;
+    try {
+      for (; i < count; i++) {
+        construct(dest + i, src[i]);
+      }
+    } catch (...) {
+      destroy_range(dest, i);
+      throw;
+    }
+  }
+
+  // Number of live elements stored from `front_idx` up to the end of the
+  // buffer. The remaining `vec_size - first_run()` wrap around to slot 0.
+  size_t first_run() const {
+    return min(this->vec_size, this->capacity - this->front_idx);
+  }
+
+  // Copy-constructs every element of `other`, in logical order, into the
+  // uninitialized array `dest` (allocated by this vector's allocator).
+  // Trivially copyable elements go as at most two memcpys.
+  void copy_into(T *dest, const CircVector &other) {
+    this->stats.on_copy(other.vec_size * sizeof(T));
+    // A moved-from `other` has no buffer, and `memcpy` takes no null source.
+    if (other.vec_size == 0) {
+      return;
+    }
+    size_t head = other.first_run();
+    if constexpr (is_trivially_copyable_v<T>) {
+      memcpy(dest, other.data + other.front_idx, head * sizeof(T));
+      memcpy(dest + head, other.data, (other.vec_size - head) * sizeof(T));
+    } else {
+      construct_copies(other.data + other.front_idx, head, dest);
+      try {
+        construct_copies(other.data, other.vec_size - head, dest + head);
+      } catch (...) {
+        destroy_range(dest, head);
+        throw;
+      }
+    }
+  }
+
+  // Moves every element, in logical order, into the uninitialized array
+  // `dest` and ends the lifetime of the originals. Trivially relocatable
+  // elements go as at most two memcpys with no constructor/destructor calls.
+  // Elements whose move may throw are copied instead, so if a copy throws,
+  // the ones already made are destroyed and the ring is left as it was
+  // (unless `T` is move-only with a throwing move).
+  void relocate_into(T *dest) {
+    if (this->vec_size == 0) {
+      return;
+    }
+    size_t head = first_run();
+    if constexpr (is_trivially_relocatable<T>::value) {
+      memcpy(static_cast<void *>(dest), this->data + this->front_idx,
+             head * sizeof(T));
+      memcpy(static_cast<void *>(dest + head), this->data,
+             (this->vec_size - head) * sizeof(T));
+    } else {
+      size_t i = 0;
+      try {
+        for (; i < this->vec_size; i++) {
+          construct(dest + i, move_if_noexcept(slot(i)));
+        }
+      } catch (...) {
+        destroy_range(dest, i);
+        throw;
+      }
+      destroy_all();
+    }
+  }
+
+  // Destroys every live element. Leaves `vec_size` untouched.
+  void destroy_all() {
+    size_t head = first_run();
+    destroy_range(this->data + this->front_idx, head);
+    destroy_range(this->data, this->vec_size - head);
+  }
+
+  // The capacity the growth policy takes a full buffer to. A fixed-capacity
+  // ring only ever grows from no buffer at all (after being moved from).
+  size_t grown_capacity() const {
+    if constexpr (overwrites) {
+      if (this->capacity != 0) {
+        throw length_error("fixed-capacity ring is full");
+      }
+      return 0;
+    } else {
+      return GrowthPolicy::grow(this->capacity);
+    }
   }
 
   void resize() {
-    T *newData = new T[this->capacity*2];
-    for (int i = 0; i < this->vec_size; i++) {
-      newData[i] = this->at(i);
+    // A moved-from `CircVector` has no buffer; start it over at the default.
+    reallocate(buffer_capacity(CapacityPolicy::round(
+        this->capacity == 0 ? 10 : grown_capacity())));
+  }
+
+  // Grows the buffer, if needed, so that `extra` more elements fit without
+  // another reallocation. Grows at least as much as the growth policy would,
+  // to keep pushes amortized.
+  void grow_for(size_t extra) {
+    size_t needed = this->vec_size + extra;
+    if (needed <= this->capacity) {
+      return;
+    }
+    reallocate(
+        buffer_capacity(CapacityPolicy::round(max(needed, grown_capacity()))));
+  }
+
+  // Whether a push must overwrite rather than grow.
+  bool overwrite_now() const {
+    if constexpr (overwrites) {
+      return this->vec_size == this->capacity && this->capacity != 0;
+    } else {
+      return false;
+    }
+  }
+
+  // Drops `count` elements from the front (the oldest) or the back (the
+  // newest) of a fixed-capacity ring to make room, and counts them.
+  void discard_front(size_t count) {
+    for (size_t i = 0; i < count; i++) {
+      destroy_elem(&slot(i));
+    }
+    this->front_idx = wrap(this->front_idx, count);
+    this->vec_size -= count;
+    this->overwritten += count;
+  }
+
+  void discard_back(size_t count) {
+    for (size_t i = this->vec_size - count; i < this->vec_size; i++) {
+      destroy_elem(&slot(i));
+    }
+    this->vec_size -= count;
+    this->overwritten += count;
+  }
+
+  // For `append`/`prepend` on a fixed-capacity ring: trims `elems` to the
+  // part that would survive pushing them one by one (the last `capacity` for
+  // an append, the first `capacity` for a prepend), and discards the elements
+  // those pushes would overwrite.
+  span<const T> overwrite_for(span<const T> elems, bool at_back) {
+    if (this->capacity == 0) {
+      return elems;
+    }
+    if (elems.size() > this->capacity) {
+      this->overwritten += elems.size() - this->capacity;
+      elems = at_back ? elems.last(this->capacity)
+                      : elems.first(this->capacity);
+    }
+    size_t room = this->capacity - this->vec_size;
+    if (elems.size() > room) {
+      if (at_back) {
+        discard_front(elems.size() - room);
+      } else {
+        discard_back(elems.size() - room);
+      }
+    }
+    return elems;
+  }
+
+  // Constructs a `T` from `args` in the free slot before the front or after
+  // the back, which the caller has made sure exists.
+  template <typename... Args>
+  T &place_front(Args &&...args) {
+    size_t idx = wrap_back(this->front_idx);
+    construct(this->data + idx, forward<Args>(args)...);
+    this->front_idx = idx;
+    this->vec_size++;
+    return this->data[idx];
+  }
+
+  template <typename... Args>
+  T &place_back(Args &&...args) {
+    size_t idx = wrap(this->front_idx, this->vec_size);
+    construct(this->data + idx, forward<Args>(args)...);
+    this->vec_size++;
+    return this->data[idx];
+  }
+
+  // Moves the elements into a fresh buffer of `newCapacity` slots, which
+  // must be at least `vec_size`. The front ends up at slot 0, except when
+  // the buffer grows in place (see `remap`).
+  void reallocate(size_t newCapacity) {
+    [[maybe_unused]] auto timer = this->stats.time(StatsOp::resize);
+    if constexpr (remappable) {
+      if (newCapacity > this->capacity && this->data != nullptr &&
+          !is_inline() && this->alloc.is_mapped(this->capacity) &&
+          this->alloc.is_mapped(newCapacity)) {
+        remap(newCapacity);
+        return;
+      }
+    }
+
+    T *newData = allocate(newCapacity);
+    try {
+      relocate_into(newData);
+    } catch (...) {
+      deallocate(newData, newCapacity);
+      throw;
+    }
+    this->stats.on_resize(this->vec_size * sizeof(T));
+
+    deallocate(this->data, this->capacity);
+    this->data = newData;
+    this->capacity = newCapacity;
+    this->front_idx = 0;
+  }
+
+  // Grows the buffer with `Allocator::reallocate`, so the old slots keep
+  // their contents without being copied, then repairs a wrapped ring: the
+  // wrapped run moves up past the old end if it is the shorter one and fits
+  // there, otherwise the front run moves to the new end. Either way at most
+  // half the elements are moved, and peak memory stays at one buffer.
+  void remap(size_t newCapacity) {
+    size_t head = first_run();
+    size_t tail = this->vec_size - head;
+    bool copied_all = false;
+    this->data = this->alloc.reallocate(this->data, this->capacity,
+                                        newCapacity, &copied_all);
+    this->stats.on_capacity(newCapacity);
+
+    // Elements copied to close the wrap, plus the whole old buffer if the
+    // allocator could not move its pages.
+    size_t copied = copied_all ? this->capacity : 0;
+    if (tail > 0) {
+      if (tail <= head && tail <= newCapacity - this->capacity) {
+        memcpy(static_cast<void *>(this->data + this->capacity), this->data,
+               tail * sizeof(T));
+        copied += tail;
+      } else {
+        size_t start = newCapacity - head;
+        memmove(static_cast<void *>(this->data + start),
+                this->data + this->front_idx, head * sizeof(T));
+        this->front_idx = start;
+        copied += head;
+      }
+    }
+    this->stats.on_resize(copied * sizeof(T));
+    this->capacity = newCapacity;
+  }
+
+  // Called after elements are removed. Halves the capacity, as many times as
+  // needed, until occupancy is back at or above `shrink_below` or the next
+  // halving would go under `min_capacity`. Growth only happens at full
+  // occupancy and a shrink leaves the ring under `2 * shrink_below` full, so
+  // a workload hovering around one size does not reallocate back and forth.
+  void auto_shrink() {
+    if (this->shrink_below == 0) {
+      return;
+    }
+
+    size_t target = this->capacity;
+    while (target > this->min_capacity &&
+           this->vec_size < target * this->shrink_below) {
+      size_t half = CapacityPolicy::round(target / 2);
+      if (half >= target || half < this->min_capacity) {
+        break;
+      }
+      target = half;
+    }
+    target = buffer_capacity(target);
+    if (target >= this->capacity) {
+      return;
     }
 
-    delete[] this->data;
+    // Shrinking only saves memory; if it cannot allocate or move the
+    // elements, keep the old buffer rather than failing the removal that
+    // triggered it.
+    T *newData;
+    try {
+      newData = allocate(target);
+    } catch (const bad_alloc &) {
+      return;
+    }
+    try {
+      relocate_into(newData);
+    } catch (...) {
+      deallocate(newData, target);
+      return;
+    }
+    deallocate(this->data, this->capacity);
     this->data = newData;
-    this->capacity *= 2;
+    this->capacity = target;
     this->front_idx = 0;
   }
 
+  // Copy-constructs `count` elements from `src` into the uninitialized ring
+  // slots starting at physical index `start`, wrapping at most once.
+  void copy_to_ring(size_t start, const T *src, size_t count) {
+    size_t head = min(count, this->capacity - start);
+    if constexpr (is_trivially_copyable_v<T>) {
+      memcpy(this->data + start, src, head * sizeof(T));
+      memcpy(this->data, src + head, (count - head) * sizeof(T));
+    } else {
+      construct_copies(src, head, this->data + start);
+      try {
+        construct_copies(src + head, count - head, this->data);
+      } catch (...) {
+        destroy_range(this->data + start, head);
+        throw;
+      }
+    }
+  }
+
+  // Move-assigns `count` live elements starting at physical index `start`
+  // into `dest`, wrapping at most once, and destroys the originals.
+  void move_from_ring(size_t start, T *dest, size_t count) {
+    size_t head = min(count, this->capacity - start);
+    if constexpr (is_trivially_copyable_v<T>) {
+      memcpy(dest, this->data + start, head * sizeof(T));
+      memcpy(dest + head, this->data, (count - head) * sizeof(T));
+    } else {
+      move(this->data + start, this->data + start + head, dest);
+      move(this->data, this->data + count - head, dest + head);
+      destroy_range(this->data + start, head);
+      destroy_range(this->data, count - head);
+    }
+  }
+
+  // Random-access iterator over the logical order of the ring. Stores the
+  // logical index, so it stays valid across pushes that do not reallocate
+  // (though it may then refer to a different element).
+  template <bool IsConst>
+  class Iterator {
+   private:
+    using Vec = conditional_t<IsConst, const CircVector, CircVector>;
+
+    Vec *vec;
+    size_t index;
+
+    friend class CircVector;
+
+    Iterator(Vec *vec, size_t index) : vec(vec), index(index) {
+    }
+
+   public:
+    using iterator_concept = random_access_iterator_tag;
+    using iterator_category = random_access_iterator_tag;
+    using value_type = T;
+    using difference_type = ptrdiff_t;
+    using reference = conditional_t<IsConst, const T &, T &>;
+    using pointer = conditional_t<IsConst, const T *, T *>;
+
+    Iterator() : vec(nullptr), index(0) {
+    }
+
+    // Allows `iterator` to convert to `const_iterator`.
+    template <bool OtherConst>
+      requires(IsConst && !OtherConst)
+    Iterator(const Iterator<OtherConst> &other)
+        : vec(other.vec), index(other.index) {
+    }
+
+    reference operator*() const {
+      return vec->data[vec->wrap(vec->front_idx, this->index)];
+    }
+
+    pointer operator->() const {
+      return &**this;
+    }
+
+    reference operator[](difference_type n) const {
+      return *(*this + n);
+    }
+
+    Iterator &operator++() {
+      this->index++;
+      return *this;
+    }
+
+    Iterator operator++(int) {
+      Iterator old = *this;
+      this->index++;
+      return old;
+    }
+
+    Iterator &operator--() {
+      this->index--;
+      return *this;
+    }
+
+    Iterator operator--(int) {
+      Iterator old = *this;
+      this->index--;
+      return old;
+    }
+
+    // Negative offsets wrap around in size_t and cancel out again, as long
+    // as the result stays within [0, size()].
+    Iterator &operator+=(difference_type n) {
+      this->index += n;
+      return *this;
+    }
+
+    Iterator &operator-=(difference_type n) {
+      this->index -= n;
+      return *this;
+    }
+
+    friend Iterator operator+(Iterator it, difference_type n) {
+      return it += n;
+    }
+
+    friend Iterator operator+(difference_type n, Iterator it) {
+      return it += n;
+    }
+
+    friend Iterator operator-(Iterator it, difference_type n) {
+      return it -= n;
+    }
+
+    friend difference_type operator-(const Iterator &a, const Iterator &b) {
+      return static_cast<difference_type>(a.index - b.index);
+    }
+
+    friend bool operator==(const Iterator &a, const Iterator &b) {
+      return a.index == b.index;
+    }
+
+    friend strong_ordering operator<=>(const Iterator &a, const Iterator &b) {
+      return a.index <=> b.index;
+    }
+
+    template <bool>
+    friend class Iterator;
+  };
+
  public:
+  using iterator = Iterator<false>;
+  using const_iterator = Iterator<true>;
+
   /**
-   * Default constructor. Creates an empty `CircVector` with capacity 10.
+   * Default constructor. Creates an empty `CircVector` with capacity 10
+   * (rounded up by the capacity policy), or the inline capacity if there is
+   * one.
    */
-  CircVector() {
-    this->vec_size = 0;
-    this->capacity = 10;
-    this->data = new T[10];
-    this->front_idx = 0;
+  CircVector() : CircVector(InlineCapacity > 0 ? InlineCapacity : 10) {
   }
 
   /**
-   * Creates an empty `CircVector` with given capacity. Capacity must exceed 0.
+   * Creates an empty `CircVector` with the default capacity whose memory
+   * comes from the given allocator.
    */
-  CircVector(size_t capacity) {
+  explicit CircVector(const Allocator &alloc)
+      : CircVector(InlineCapacity > 0 ? InlineCapacity : 10, alloc) {
+  }
+
+  /**
+   * Creates an empty `CircVector` with given capacity, rounded up by the
+   * capacity policy. Capacity must exceed 0.
+   */
+  CircVector(size_t capacity, const Allocator &alloc = Allocator())
+      : alloc(alloc) {
     if (capacity > 0) {
-      this->capacity = capacity;
+      this->capacity = buffer_capacity(CapacityPolicy::round(capacity));
     } else {
       throw out_of_range("invalid capacity. must exceed zero");
     }
 
+    this->shrink_below = 0;
+    this->min_capacity = this->capacity;
+    this->overwritten = 0;
     this->front_idx = 0;
     this->vec_size = 0;
-    this->data = new T[this->capacity];
+    this->data = nullptr;
+    this->data = allocate(this->capacity);
   }
 
   /**
    * Returns whether the `CircVector` is empty (i.e. whether its
    * size is 0).
    */
-  bool empty() const {
+  bool empty() const noexcept {
     return this->vec_size == 0;
   }
 
   /**
    * Returns the number of elements in the `CircVector`.
    */
-  size_t size() const {
+  size_t size() const noexcept {
     return this->vec_size;
   }
 
   /**
-   * Adds the given `T` to the front of the `CircVector`.
+   * Constructs a `T` from `args` directly in the slot before the front of the
+   * `CircVector`, and returns a reference to it.
    */
-  void push_front(T elem) {
+  template <typename... Args>
+  T &emplace_front(Args &&...args) {
+    [[maybe_unused]] auto timer = this->stats.time(StatsOp::push_front);
+    if (overwrite_now()) {
+      // The slot before the front is the back: replace the newest element.
+      size_t idx = wrap_back(this->front_idx);
+      this->data[idx] = T(forward<Args>(args)...);
+      this->front_idx = idx;
+      this->overwritten++;
+      return this->data[idx];
+    }
     if (this->vec_size == this->capacity) {
+      // `args` may refer into this ring, so build the element before the
+      // buffer it lives in is relocated.
+      T elem(forward<Args>(args)...);
       resize();
+      return place_front(move(elem));
     }
-
-    this->front_idx = wrap(this->front_idx, -1);
-    this->data[this->front_idx] = elem;
-    this->vec_size++;
+    return place_front(forward<Args>(args)...);
   }
 
   /**
-   * Adds the given `T` to the back of the `CircVector`.
+   * Constructs a `T` from `args` directly in the slot after the back of the
+   * `CircVector`, and returns a reference to it.
    */
-  void push_back(T elem) {
+  template <typename... Args>
+  T &emplace_back(Args &&...args) {
+    [[maybe_unused]] auto timer = this->stats.time(StatsOp::push_back);
+    if (overwrite_now()) {
+      // The slot after the back is the front: replace the oldest element.
+      size_t idx = this->front_idx;
+      this->data[idx] = T(forward<Args>(args)...);
+      this->front_idx = wrap(idx, 1);
+      this->overwritten++;
+      return this->data[idx];
+    }
     if (this->vec_size == this->capacity) {
+      T elem(forward<Args>(args)...);
       resize();
+      return place_back(move(elem));
     }
+    return place_back(forward<Args>(args)...);
+  }
 
-    this->data[wrap(this->front_idx, this->vec_size)] = elem;
-    this->vec_size++;
+  /**
+   * Adds the given `T` to the front of the `CircVector`.
+   */
+  void push_front(const T &elem) {
+    emplace_front(elem);
+  }
+
+  void push_front(T &&elem) {
+    emplace_front(move(elem));
   }
 
   /**
-   * Removes the element at the front of the `CircVector`.
+   * Adds the given `T` to the back of the `CircVector`.
+   */
+  void push_back(const T &elem) {
+    emplace_back(elem);
+  }
+
+  void push_back(T &&elem) {
+    emplace_back(move(elem));
+  }
+
+  /**
+   * Removes the element at the front of the `CircVector` and returns it by
+   * move.
    *
    * If the `CircVector` is empty, throws a `runtime_error`.
    */
   T pop_front() {
+    [[maybe_unused]] auto timer = this->stats.time(StatsOp::pop_front);
     if (this->vec_size == 0) {
       throw runtime_error("operation can not be performed on empty vector");
     }
 
-    T idxData = data[this->front_idx];
+    T idxData = move(data[this->front_idx]);
+    destroy_elem(this->data + this->front_idx);
     this->front_idx = wrap(this->front_idx, 1);
     this->vec_size--;
+    auto_shrink();
     return idxData;
   }
 
   /**
-   * Removes the element at the back of the `CircVector`.
+   * Removes the element at the back of the `CircVector` and returns it by
+   * move.
    *
    * If the `CircVector` is empty, throws a `runtime_error`.
    */
   T pop_back() {
+    [[maybe_unused]] auto timer = this->stats.time(StatsOp::pop_back);
     if (this->vec_size == 0) {
       throw runtime_error("operation can not be performed on empty vector");
     }
 
-    int idx = wrap(this->front_idx, this->vec_size - 1);
-    size_t idxData = this->data[idx];
+    size_t idx = wrap(this->front_idx, this->vec_size - 1);
+    T idxData = move(this->data[idx]);
+    destroy_elem(this->data + idx);
     this->vec_size--;
+    auto_shrink();
     return idxData;
   }
 
   /**
-   * Removes all elements from the `CircVector`.
+   * Removes the element at the front of the `CircVector` and returns it, or
+   * returns nothing if the `CircVector` is empty.
+   */
+  optional<T> try_pop_front() {
+    if (this->vec_size == 0) {
+      return nullopt;
+    }
+    return pop_front();
+  }
+
+  /**
+   * Removes the element at the back of the `CircVector` and returns it, or
+   * returns nothing if the `CircVector` is empty.
+   */
+  optional<T> try_pop_back() {
+    if (this->vec_size == 0) {
+      return nullopt;
+    }
+    return pop_back();
+  }
+
+  /**
+   * Appends copies of every element of `elems` to the back of the
+   * `CircVector`, in order. Reallocates at most once, then copies into at most
+   * two contiguous runs of the ring. `elems` must not alias this `CircVector`.
+   */
+  void append(span<const T> elems) {
+    if (elems.empty()) {
+      return;
+    }
+    if constexpr (overwrites) {
+      elems = overwrite_for(elems, true);
+    }
+    grow_for(elems.size());
+    copy_to_ring(wrap(this->front_idx, this->vec_size), elems.data(),
+                 elems.size());
+    this->vec_size += elems.size();
+  }
+
+  /**
+   * Prepends copies of every element of `elems` to the front of the
+   * `CircVector`, keeping their order: `elems[0]` becomes the new front.
+   * Reallocates at most once. `elems` must not alias this `CircVector`.
+   */
+  void prepend(span<const T> elems) {
+    if (elems.empty()) {
+      return;
+    }
+    if constexpr (overwrites) {
+      elems = overwrite_for(elems, false);
+    }
+    grow_for(elems.size());
+    // Stepping back `n` slots is stepping forward `capacity - n` of them.
+    size_t start = wrap(this->front_idx, this->capacity - elems.size());
+    copy_to_ring(start, elems.data(), elems.size());
+    this->front_idx = start;
+    this->vec_size += elems.size();
+  }
+
+  /**
+   * Removes up to `count` elements from the front of the `CircVector` and
+   * move-assigns them, in order, into `out`, which must hold at least `count`
+   * elements. Returns the number of elements removed.
+   */
+  size_t pop_front_n(T *out, size_t count) {
+    count = min(count, this->vec_size);
+    if (count == 0) {
+      return 0;
+    }
+    move_from_ring(this->front_idx, out, count);
+    this->front_idx = wrap(this->front_idx, count);
+    this->vec_size -= count;
+    auto_shrink();
+    return count;
+  }
+
+  /**
+   * Removes up to `count` elements from the back of the `CircVector` and
+   * move-assigns them into `out` in front-to-back order (so `out[0]` is the
+   * earliest removed element, not the old back). Returns the number of
+   * elements removed.
+   */
+  size_t pop_back_n(T *out, size_t count) {
+    count = min(count, this->vec_size);
+    if (count == 0) {
+      return 0;
+    }
+    move_from_ring(wrap(this->front_idx, this->vec_size - count), out, count);
+    this->vec_size -= count;
+    auto_shrink();
+    return count;
+  }
+
+  /**
+   * Removes all elements from the `CircVector`. Keeps the buffer unless
+   * auto-shrink is on.
    */
   void clear() {
+    destroy_all();
     this->vec_size = 0;
+    auto_shrink();
+  }
+
+  /**
+   * Grows the buffer, in a single reallocation, so that at least `count`
+   * elements fit before the next one. Never shrinks it. The reserved
+   * capacity is also a floor for auto-shrink. A fixed-capacity ring
+   * (`OverwriteOnFull`) keeps its capacity, unless it has no buffer at all.
+   */
+  void reserve(size_t count) {
+    if constexpr (overwrites) {
+      if (this->capacity != 0) {
+        return;
+      }
+    }
+    if (count > this->capacity) {
+      reallocate(buffer_capacity(CapacityPolicy::round(count)));
+    }
+    this->min_capacity = max(this->min_capacity, CapacityPolicy::round(count));
+  }
+
+  /**
+   * Reallocates the buffer down to the smallest capacity the capacity policy
+   * allows for the current size (at least 1). Ignores the auto-shrink floor.
+   * If the elements fit in the inline buffer, moves them there at the full
+   * inline capacity, and does nothing if they already are. Does nothing on a
+   * fixed-capacity ring (`OverwriteOnFull`), whose capacity is its window.
+   */
+  void shrink_to_fit() {
+    if constexpr (overwrites) {
+      return;
+    }
+    size_t target = buffer_capacity(
+        CapacityPolicy::round(max<size_t>(this->vec_size, 1)));
+    if (target < this->capacity) {
+      reallocate(target);
+    }
+  }
+
+  /**
+   * Turns on auto-shrink: whenever removing elements (by a pop, `clear`,
+   * `remove_at`, `erase`, `remove`, `remove_if` or `remove_every_other`)
+   * leaves fewer than `threshold * capacity` of them, the capacity is halved
+   * (repeatedly if need be), never below the initial or reserved capacity.
+   * 0 turns it off.
+   * The threshold must be below 0.5 so that a shrunk ring is not already
+   * full; 0.25 is a good default.
+   * A fixed-capacity ring (`OverwriteOnFull`) cannot turn it on.
+   *
+   * If the threshold is out of range, throws `invalid_argument`.
+   */
+  void set_auto_shrink(double threshold) {
+    static_assert(!overwrites,
+                  "a fixed-capacity ring cannot shrink its window");
+    if (!(threshold >= 0 && threshold < 0.5)) {
+      throw invalid_argument("shrink threshold must be in [0, 0.5)");
+    }
+    this->shrink_below = threshold;
   }
 
   /**
    * Destructor. Clears all allocated memory.
    */
   ~CircVector() {
-    delete[] this->data;
+    destroy_all();
+    deallocate(this->data, this->capacity);
   }
 
   /**
@@ -153,28 +1055,110 @@ class CircVector {
    * If the index is invalid, throws `out_of_range`.
    */
   T &at(size_t index) const {
-    if (index < 0 || index >= this->size()) {
+    [[maybe_unused]] auto timer = this->stats.time(StatsOp::at);
+    if (index >= this->size()) {
       throw out_of_range("index is out of range");
     }
-    int indx = wrap(this->front_idx, index);
-  
+    size_t indx = wrap(this->front_idx, index);
+
     return this->data[indx];
   }
 
+  /**
+   * Returns the element at the given index without bounds checking. With
+   * checked access on (see `checks.h`), an invalid index aborts instead.
+   */
+  T &operator[](size_t index) noexcept {
+    expects(index < this->vec_size, "CircVector index is out of range");
+    return slot(index);
+  }
+
+  const T &operator[](size_t index) const noexcept {
+    expects(index < this->vec_size, "CircVector index is out of range");
+    return slot(index);
+  }
+
+  /**
+   * Returns the element at the front of the `CircVector`, which must not be
+   * empty (checked only with checked access on).
+   */
+  T &front() noexcept {
+    expects(this->vec_size != 0, "front() of empty CircVector");
+    return this->data[this->front_idx];
+  }
+
+  const T &front() const noexcept {
+    expects(this->vec_size != 0, "front() of empty CircVector");
+    return this->data[this->front_idx];
+  }
+
+  /**
+   * Returns the element at the back of the `CircVector`, which must not be
+   * empty (checked only with checked access on).
+   */
+  T &back() noexcept {
+    expects(this->vec_size != 0, "back() of empty CircVector");
+    return slot(this->vec_size - 1);
+  }
+
+  const T &back() const noexcept {
+    expects(this->vec_size != 0, "back() of empty CircVector");
+    return slot(this->vec_size - 1);
+  }
+
   /**
    * Copy constructor. Creates a deep copy of the given `CircVector`.
    *
    * Must run in O(N) time.
    */
-  CircVector(const CircVector &other) {
-    this->data = new T[other.capacity];
-    for (int i = 0; i < other.size(); i++) {
-      this->data[i] = other.at(i);
+  CircVector(const CircVector &other)
+      : alloc(alloc_traits::select_on_container_copy_construction(
+            other.alloc)) {
+    size_t newCapacity = buffer_capacity(other.capacity);
+    this->data = nullptr;
+    this->data = allocate(newCapacity);
+    try {
+      copy_into(this->data, other);
+    } catch (...) {
+      deallocate(this->data, newCapacity);
+      throw;
     }
 
-    this->capacity = other.capacity;
+    this->capacity = newCapacity;
     this->vec_size = other.vec_size;
     this->front_idx = 0;
+    this->shrink_below = other.shrink_below;
+    this->min_capacity = other.min_capacity;
+    this->overwritten = other.overwritten;
+  }
+
+  /**
+   * Move constructor. Takes over the buffer of the given `CircVector`, which
+   * is left empty with no buffer. Runs in O(1) time, except that elements in
+   * an inline buffer are moved one by one (and `other` keeps its buffer).
+   */
+  CircVector(CircVector &&other) noexcept(
+      InlineCapacity == 0 || is_trivially_relocatable<T>::value ||
+      is_nothrow_move_constructible_v<T>)
+      : alloc(move(other.alloc)) {
+    this->shrink_below = other.shrink_below;
+    this->min_capacity = other.min_capacity;
+    this->overwritten = other.overwritten;
+    other.overwritten = 0;
+    if (other.is_inline()) {
+      take_inline(other);
+      return;
+    }
+
+    this->data = other.data;
+    this->vec_size = other.vec_size;
+    this->capacity = other.capacity;
+    this->front_idx = other.front_idx;
+
+    other.data = nullptr;
+    other.vec_size = 0;
+    other.capacity = 0;
+    other.front_idx = 0;
   }
 
   /**
@@ -189,15 +1173,100 @@ class CircVector {
       return *this;
     }
 
-    delete[] this->data;
-    this->data = new T[other.capacity];
-    this->capacity = other.capacity;
-    this->vec_size = other.vec_size;
+    destroy_all();
+    this->vec_size = 0;
+    if constexpr (alloc_traits::propagate_on_container_copy_assignment::value) {
+      if (this->alloc != other.alloc) {
+        // The old buffer must go back to the allocator that made it.
+        deallocate(this->data, this->capacity);
+        this->data = nullptr;
+        this->capacity = 0;
+        this->alloc = other.alloc;
+      }
+    }
+    if (this->capacity != buffer_capacity(other.capacity)) {
+      // Release first, so a freed inline buffer can be handed out again.
+      deallocate(this->data, this->capacity);
+      this->data = nullptr;
+      this->capacity = 0;
+      this->data = allocate(buffer_capacity(other.capacity));
+      this->capacity = buffer_capacity(other.capacity);
+    }
     this->front_idx = 0;
 
-    for (int i = 0; i < other.size(); i++) {
-      this->data[i] = other.at(i);
+    copy_into(this->data, other);
+    this->vec_size = other.vec_size;
+    this->shrink_below = other.shrink_below;
+    this->min_capacity = other.min_capacity;
+    this->overwritten = other.overwritten;
+    return *this;
+  }
+
+  /**
+   * Move assignment operator. Releases the current contents and takes over
+   * the buffer of the given `CircVector`, which is left empty with no
+   * buffer. Runs in O(N) time for the destroyed elements, O(1) otherwise.
+   *
+   * If the allocators differ and do not propagate on move, or the buffer is
+   * inline, it cannot change hands; the elements are moved one by one
+   * instead.
+   */
+  CircVector &operator=(CircVector &&other) noexcept(
+      (alloc_traits::propagate_on_container_move_assignment::value ||
+       alloc_traits::is_always_equal::value) &&
+      (InlineCapacity == 0 || is_trivially_relocatable<T>::value ||
+       is_nothrow_move_constructible_v<T>)) {
+    if (this == &other) {
+      return *this;
+    }
+
+    this->shrink_below = other.shrink_below;
+    this->min_capacity = other.min_capacity;
+    if constexpr (!alloc_traits::propagate_on_container_move_assignment::
+                      value) {
+      if (this->alloc != other.alloc) {
+        destroy_all();
+        this->vec_size = 0;
+        this->front_idx = 0;
+        if (this->capacity < other.vec_size) {
+          deallocate(this->data, this->capacity);
+          this->data = nullptr;
+          this->capacity = 0;
+          this->data = allocate(buffer_capacity(other.capacity));
+          this->capacity = buffer_capacity(other.capacity);
+        }
+        for (size_t i = 0; i < other.vec_size; i++) {
+          construct(this->data + i, move(other.slot(i)));
+          this->vec_size++;
+        }
+        this->overwritten = other.overwritten;
+        other.clear();
+        other.overwritten = 0;
+        return *this;
+      }
+    }
+
+    destroy_all();
+    deallocate(this->data, this->capacity);
+    if constexpr (alloc_traits::propagate_on_container_move_assignment::value) {
+      this->alloc = move(other.alloc);
     }
+    this->overwritten = other.overwritten;
+    other.overwritten = 0;
+    if (other.is_inline()) {
+      take_inline(other);
+      return *this;
+    }
+
+    this->data = other.data;
+    this->vec_size = other.vec_size;
+    this->capacity = other.capacity;
+    this->front_idx = other.front_idx;
+
+    other.data = nullptr;
+    other.vec_size = 0;
+    other.capacity = 0;
+    other.front_idx = 0;
     return *this;
   }
 
@@ -210,10 +1279,9 @@ class CircVector {
     stringstream oss;
 
     oss << '[';
-    for (int i = 0; i < this->vec_size; i++) {
-      T cvString = this->at(i);
-      oss << cvString;
-      
+    for (size_t i = 0; i < this->vec_size; i++) {
+      oss << slot(i);
+
       if (i == this->vec_size - 1) {
         break;
       } else {
@@ -226,21 +1294,141 @@ class CircVector {
     return oss.str();
   }
 
+  /**
+   * Writes the same text as `to_string()` into `[first, last)` and returns
+   * the end of it, like `to_chars`. Arithmetic and string elements are
+   * formatted without allocating (see `format_elem`). If the buffer is too
+   * small, returns `{last, errc::value_too_large}`.
+   */
+  to_chars_result format_to(char *first, char *last) const {
+    to_chars_result result = format_text(first, last, "[");
+    for (size_t i = 0; i < this->vec_size && result.ec == errc(); i++) {
+      if (i != 0) {
+        result = format_text(result.ptr, last, ", ");
+        if (result.ec != errc()) {
+          break;
+        }
+      }
+      result = format_elem(result.ptr, last, slot(i));
+    }
+    if (result.ec != errc()) {
+      return result;
+    }
+    return format_text(result.ptr, last, "]");
+  }
+
+  /**
+   * Writes the `CircVector` to `out` in the binary format of
+   * `serialization.h`: the size, then the elements front to back. Trivially
+   * copyable elements on a little-endian host go out as (at most) two bulk
+   * writes.
+   */
+  void serialize(ostream &out) const {
+    Serializer<uint64_t>::write(out, this->vec_size);
+    if constexpr (Serializer<T>::raw_bulk) {
+      auto [head, tail] = this->as_spans();
+      write_bytes(out, head.data(), head.size_bytes());
+      write_bytes(out, tail.data(), tail.size_bytes());
+    } else {
+      for (size_t i = 0; i < this->vec_size; i++) {
+        Serializer<T>::write(out, slot(i));
+      }
+    }
+  }
+
+  /**
+   * Replaces the contents of the `CircVector` with ones read from `in`, as
+   * written by `serialize`. Reallocates at most once; trivially copyable
+   * elements are read straight into the buffer. A fixed-capacity ring
+   * (`OverwriteOnFull`) keeps its capacity and reads the elements as a
+   * sequence of pushes, so only the newest ones stay.
+   *
+   * If `in` ends early, throws `runtime_error`.
+   */
+  void deserialize(istream &in) {
+    size_t count = Serializer<uint64_t>::read(in);
+    destroy_all();
+    this->vec_size = 0;
+    this->front_idx = 0;
+    if constexpr (overwrites) {
+      if (count > this->capacity && this->capacity != 0) {
+        for (size_t i = 0; i < count; i++) {
+          emplace_back(Serializer<T>::read(in));
+        }
+        return;
+      }
+    }
+    if (count > this->capacity) {
+      reallocate(buffer_capacity(CapacityPolicy::round(count)));
+    }
+
+    if constexpr (Serializer<T>::raw_bulk) {
+      read_bytes(in, this->data, count * sizeof(T));
+      this->vec_size = count;
+    } else {
+      for (size_t i = 0; i < count; i++) {
+        emplace_back(Serializer<T>::read(in));
+      }
+    }
+  }
+
   /**
    * Searches the `CircVector` for the first matching element, and returns its
    * index in the `CircVector`. If no match is found, returns "-1".
+   *
+   * Scans the two contiguous runs of the ring directly, with SIMD compares
+   * for arithmetic element types (see `simdscan.h`).
    */
-  size_t find(const T &target) {
-    for (int i = 0; i < this->vec_size; i++) {
-      if (data[wrap(this->front_idx, i)] == target) {
-        return i;
-      }
+  size_t find(const T &target) const {
+    auto [head, tail] = this->as_spans();
+    size_t idx = scan_find(head.data(), head.size(), target);
+    if (idx != head.size()) {
+      return idx;
+    }
+    idx = scan_find(tail.data(), tail.size(), target);
+    if (idx != tail.size()) {
+      return head.size() + idx;
+    }
+    return -1;
+  }
+
+  /**
+   * Searches the `CircVector` for the last matching element, and returns its
+   * index in the `CircVector`. If no match is found, returns "-1".
+   */
+  size_t rfind(const T &target) const {
+    auto [head, tail] = this->as_spans();
+    size_t idx = scan_rfind(tail.data(), tail.size(), target);
+    if (idx != tail.size()) {
+      return head.size() + idx;
+    }
+    idx = scan_rfind(head.data(), head.size(), target);
+    if (idx != head.size()) {
+      return idx;
     }
     return -1;
   }
 
   /**
-   * Remove the element at the specified index in this list.
+   * Returns the number of elements equal to `target`.
+   */
+  size_t count(const T &target) const {
+    auto [head, tail] = this->as_spans();
+    return scan_count(head.data(), head.size(), target) +
+           scan_count(tail.data(), tail.size(), target);
+  }
+
+  /**
+   * Returns whether any element is equal to `target`.
+   */
+  bool contains(const T &target) const {
+    return this->find(target) != static_cast<size_t>(-1);
+  }
+
+  /**
+   * Remove the element at the specified index in this list. Shifts whichever
+   * side of the index is shorter, so it runs in O(min(index, N - index))
+   * time and only reallocates to auto-shrink.
    *
    * If the index is invalid, throws `out_of_range`.
    */
@@ -250,77 +1438,287 @@ class CircVector {
       throw out_of_range("index is out of range");
     }
 
-    T *newData = new T[this->capacity - 1];
-    for (size_t i = 0; i < index; i++) {
-      newData[i] = this->data[wrap(this->front_idx, i)];
-    }
-
-    for (size_t i = index + 1; i < this->vec_size; i++) {
-      newData[i - 1] = this->data[wrap(this->front_idx, i)];
+    if (index < this->vec_size - 1 - index) {
+      // Close the gap from the front: shift [0, index) back by one slot.
+      for (size_t i = index; i > 0; i--) {
+        slot(i) = move(slot(i - 1));
+      }
+      destroy_elem(&slot(0));
+      this->front_idx = wrap(this->front_idx, 1);
+    } else {
+      // Close the gap from the back: shift (index, size) forward by one slot.
+      for (size_t i = index; i + 1 < this->vec_size; i++) {
+        slot(i) = move(slot(i + 1));
+      }
+      destroy_elem(&slot(this->vec_size - 1));
     }
-    
-    delete[] this->data;
-    this->data = newData;
     this->vec_size--;
-    this->front_idx = 0;
+    auto_shrink();
   }
 
   /**
-   * Inserts the given `T` as a new element in the `CircVector` after
-   * the given index. If the index is invalid, throws `out_of_range`.
+   * Constructs a `T` from `args` as a new element in the `CircVector` after
+   * the given index, and returns a reference to it. Shifts whichever side of
+   * the index is shorter, so it runs in O(min(index, N - index)) time and
+   * only reallocates when the buffer is full. If the index is invalid, throws
+   * `out_of_range`.
    */
-  void insert_after(size_t index, T elem) {
-    if (index > this->vec_size) {
-      throw out_of_range("index is out of range");
-    }
+  template <typename... Args>
+  T &emplace_after(size_t index, Args &&...args) {
     if (this->empty()){
       throw out_of_range("cant insert after on an empty vector");
     }
+    if (index >= this->vec_size) {
+      throw out_of_range("index is out of range");
+    }
 
+    // Build the new element first: `args` may refer into this ring, and the
+    // shifts below move elements around under them.
+    T elem(forward<Args>(args)...);
     if (this->vec_size == this->capacity) {
       resize();
     }
 
-    T *newData = new T[this->capacity];
-    for (int i = 0; i <= index; i++) {
-      newData[i] = this->data[wrap(this->front_idx, i)];
+    size_t pos = index + 1;
+    if (pos < this->vec_size - pos) {
+      // Open the gap toward the front: [0, pos) moves back by one slot.
+      this->front_idx = wrap_back(this->front_idx);
+      this->vec_size++;
+      construct(&slot(0), move(slot(1)));
+      for (size_t i = 1; i < pos; i++) {
+        slot(i) = move(slot(i + 1));
+      }
+    } else if (pos < this->vec_size) {
+      // Open the gap toward the back: [pos, size) moves up by one slot.
+      construct(&slot(this->vec_size), move(slot(this->vec_size - 1)));
+      this->vec_size++;
+      for (size_t i = this->vec_size - 2; i > pos; i--) {
+        slot(i) = move(slot(i - 1));
+      }
+    } else {
+      // Inserting after the back is a plain push.
+      construct(&slot(pos), move(elem));
+      this->vec_size++;
+      return slot(pos);
     }
 
-    newData[index + 1] = elem;
-    for (int i = index + 1; i < this->vec_size; i++) {
-      newData[i + 1] = this->data[wrap(this->front_idx, i)];
-    }
+    slot(pos) = move(elem);
+    return slot(pos);
+  }
 
-    delete[] this->data;
-    this->data = newData;
-    this->vec_size++;
-    this->front_idx = 0;
+  /**
+   * Inserts the given `T` as a new element in the `CircVector` after
+   * the given index. If the index is invalid, throws `out_of_range`.
+   */
+  void insert_after(size_t index, const T &elem) {
+    emplace_after(index, elem);
+  }
+
+  void insert_after(size_t index, T &&elem) {
+    emplace_after(index, move(elem));
   }
 
   /**
    * Remove every other element (alternating) from the
-   * `CircVector`, starting at index 1. Must run in O(N). May not reallocate.
+   * `CircVector`, starting at index 1. Must run in O(N). May not reallocate,
+   * except to auto-shrink if that is turned on.
    */
   void remove_every_other() {
     if (this->vec_size == 0 || this->vec_size == 1) {
       return;
     }
 
-    int counter = 0;
-    for (int i = 0; i < this->vec_size; i++) {
-      if (i % 2 == 0) {
-        this->at(counter) = this->at(i);
-        counter++;
+    size_t kept = (this->vec_size + 1) / 2;
+    for (size_t i = 1; i < kept; i++) {
+      slot(i) = move(slot(2 * i));
+    }
+    for (size_t i = kept; i < this->vec_size; i++) {
+      destroy_elem(&slot(i));
+    }
+    this->vec_size = kept;
+    auto_shrink();
+  }
+
+  /**
+   * Removes every element for which `pred` returns true, keeping the order
+   * of the rest, and returns how many were removed. Compacts in a single
+   * pass, so it runs in O(N) time and only reallocates to auto-shrink.
+   */
+  template <typename Pred>
+  size_t remove_if(Pred pred) {
+    size_t kept = 0;
+    for (size_t i = 0; i < this->vec_size; i++) {
+      if (!pred(as_const(slot(i)))) {
+        if (kept != i) {
+          slot(kept) = move(slot(i));
+        }
+        kept++;
       }
     }
-    this->vec_size = counter;
+    for (size_t i = kept; i < this->vec_size; i++) {
+      destroy_elem(&slot(i));
     }
-    
+
+    size_t removed = this->vec_size - kept;
+    this->vec_size = kept;
+    auto_shrink();
+    return removed;
+  }
+
+  /**
+   * Keeps only the elements for which `pred` returns true. Returns how many
+   * were removed.
+   */
+  template <typename Pred>
+  size_t retain(Pred pred) {
+    return remove_if([&pred](const T &elem) { return !pred(elem); });
+  }
+
+  /**
+   * Removes every element equal to `value` and returns how many were
+   * removed. For arithmetic element types each run of the ring is compacted
+   * with SIMD compares (see `scan_remove`).
+   */
+  size_t remove(const T &value) {
+    if constexpr (simd_scannable<T>) {
+      auto [head, tail] = this->as_spans();
+      size_t headKept = scan_remove(head.data(), head.size(), value);
+      size_t tailKept = scan_remove(tail.data(), tail.size(), value);
+      if (tailKept > 0 && headKept < head.size()) {
+        // Close the gap between the runs by sliding the head survivors up
+        // against the end of the buffer, where the wrapped run continues.
+        size_t start = this->capacity - headKept;
+        memmove(this->data + start, this->data + this->front_idx,
+                headKept * sizeof(T));
+        this->front_idx = headKept == 0 ? 0 : start;
+      }
+
+      size_t removed = this->vec_size - headKept - tailKept;
+      this->vec_size = headKept + tailKept;
+      auto_shrink();
+      return removed;
+    } else {
+      return remove_if([&value](const T &elem) { return elem == value; });
+    }
+  }
+
+  /**
+   * Removes the elements at indices `[first, last)`. Shifts whichever side
+   * of the range is shorter, so it runs in O(min(first, N - last)) moves and
+   * only reallocates to auto-shrink.
+   *
+   * If the range is invalid, throws `out_of_range`.
+   */
+  void erase(size_t first, size_t last) {
+    if (first > last || last > this->vec_size) {
+      throw out_of_range("index is out of range");
+    }
+
+    size_t count = last - first;
+    if (count == 0) {
+      return;
+    }
+    if (first < this->vec_size - last) {
+      // Close the gap from the front: [0, first) moves up by `count`.
+      for (size_t i = first; i > 0; i--) {
+        slot(i - 1 + count) = move(slot(i - 1));
+      }
+      for (size_t i = 0; i < count; i++) {
+        destroy_elem(&slot(i));
+      }
+      this->front_idx = wrap(this->front_idx, count);
+    } else {
+      // Close the gap from the back: [last, size) moves down by `count`.
+      for (size_t i = last; i < this->vec_size; i++) {
+        slot(i - count) = move(slot(i));
+      }
+      for (size_t i = this->vec_size - count; i < this->vec_size; i++) {
+        destroy_elem(&slot(i));
+      }
+    }
+    this->vec_size -= count;
+    auto_shrink();
+  }
+
+
+  /**
+   * Returns an iterator to the front of the `CircVector`. Iterators are
+   * random access, so standard algorithms like `sort` work on the ring
+   * directly. Any operation that reallocates invalidates them.
+   */
+  iterator begin() {
+    return iterator(this, 0);
+  }
+
+  const_iterator begin() const {
+    return const_iterator(this, 0);
+  }
+
+  const_iterator cbegin() const {
+    return const_iterator(this, 0);
+  }
+
+  /**
+   * Returns an iterator one past the back of the `CircVector`.
+   */
+  iterator end() {
+    return iterator(this, this->vec_size);
+  }
+
+  const_iterator end() const {
+    return const_iterator(this, this->vec_size);
+  }
+
+  const_iterator cend() const {
+    return const_iterator(this, this->vec_size);
+  }
+
+  /**
+   * Returns the live elements as two contiguous runs, in logical order: the
+   * run from the front up to the end of the buffer, then the run that
+   * wrapped around to the start of it (empty if the ring does not wrap).
+   * Loops over each span are straight-line and free of index wrapping.
+   */
+  pair<span<T>, span<T>> as_spans() {
+    size_t head = first_run();
+    return {span<T>(this->data + this->front_idx, head),
+            span<T>(this->data, this->vec_size - head)};
+  }
+
+  pair<span<const T>, span<const T>> as_spans() const {
+    size_t head = first_run();
+    return {span<const T>(this->data + this->front_idx, head),
+            span<const T>(this->data, this->vec_size - head)};
+  }
+
+  /**
+   * Returns how many elements pushes onto a full ring have overwritten. Always
+   * 0 unless the growth policy is `OverwriteOnFull`.
+   */
+  size_t get_overwritten() const noexcept {
+    return this->overwritten;
+  }
+
+  /**
+   * Returns the instrumentation policy, e.g. to take a `snapshot()` of or
+   * `reset()` a `ContainerStats`.
+   */
+  Stats &get_stats() const noexcept {
+    return this->stats;
+  }
+
+  /**
+   * Returns a copy of the allocator the `CircVector` gets its memory from.
+   */
+  Allocator get_allocator() const {
+    return this->alloc;
+  }
+
   /**
    * Returns a pointer to the underlying memory managed by the `CircVec`.
    * For autograder testing purposes only.
    */
-  T *get_data() const {
+  T *get_data() const noexcept {
     return this->data;
   }
 
@@ -328,7 +1726,25 @@ class CircVector {
    * Returns the capacity of the underlying memory managed by the `CircVec`. For
    * autograder testing purposes only.
    */
-  size_t get_capacity() const {
+  size_t get_capacity() const noexcept {
     return this->capacity;
   }
 };
+
+/**
+ * `CircVector` whose memory, and that of allocator-aware elements such as
+ * `pmr::string`, comes from a `pmr::memory_resource`.
+ */
+template <typename T, typename CapacityPolicy = ExactCapacity,
+          typename GrowthPolicy = DoublingGrowth>
+using PmrCircVector = CircVector<T, CapacityPolicy,
+                                 pmr::polymorphic_allocator<T>, GrowthPolicy>;
+
+/**
+ * `CircVector` that keeps up to `N` elements inside the object and only
+ * allocates once it outgrows them, so short queues never reach the heap.
+ * With `PowerOfTwoCapacity`, `N` must be a power of two.
+ */
+template <typename T, size_t N, typename CapacityPolicy = ExactCapacity>
+using SmallCircVector =
+    CircVector<T, CapacityPolicy, allocator<T>, DoublingGrowth, N>;
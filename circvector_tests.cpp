@@ -1,7 +1,11 @@
 #include <gmock/gmock.h>  
 #include <gtest/gtest.h>
 
+#include <memory_resource>
+#include <numeric>
+
 #include "circvector.h"
+#include "hugepage_allocator.h"
 
 using namespace std;
 using namespace testing;
@@ -359,3 +363,1476 @@ TEST(CircVectorExtras, insert_resize) {
 
   EXPECT_THAT(myVec.size(), Eq(6));
 }
+
+TEST(CircVectorPolicy, power_of_two_rounds_capacity) {
+  CircVector<int, PowerOfTwoCapacity> myVec(5);
+  CircVector<int, PowerOfTwoCapacity> myVec2;
+
+  EXPECT_THAT(myVec.get_capacity(), Eq(8));
+  EXPECT_THAT(myVec2.get_capacity(), Eq(16));
+}
+
+TEST(CircVectorPolicy, power_of_two_resize) {
+  CircVector<int, PowerOfTwoCapacity> myVec(4);
+
+  for (int i = 0; i < 9; i++) {
+    myVec.push_back(i);
+  }
+
+  EXPECT_THAT(myVec.get_capacity(), Eq(16));
+  EXPECT_THAT(myVec.to_string(), StrEq("[0, 1, 2, 3, 4, 5, 6, 7, 8]"));
+}
+
+TEST(CircVectorPolicy, power_of_two_wrap) {
+  CircVector<int, PowerOfTwoCapacity> myVec(4);
+
+  myVec.push_back(3);
+  myVec.push_back(27);
+  myVec.push_front(32);
+  myVec.push_front(28);  // ring is now full and wrapped
+
+  EXPECT_THAT(myVec.to_string(), StrEq("[28, 32, 3, 27]"));
+  EXPECT_THAT(myVec.find(27), Eq(3));
+  EXPECT_THAT(myVec.pop_back(), Eq(27));
+  EXPECT_THAT(myVec.pop_front(), Eq(28));
+}
+
+TEST(CircVectorPolicy, pop_back_non_integral) {
+  CircVector<string> myVec(2);
+
+  myVec.push_back("first");
+  myVec.push_front("second");
+
+  EXPECT_THAT(myVec.pop_back(), StrEq("first"));
+}
+
+TEST(CircVectorPolicy, remove_at_keeps_capacity) {
+  CircVector<int, PowerOfTwoCapacity> myVec(4);
+
+  myVec.push_back(1);
+  myVec.push_back(2);
+  myVec.remove_at(0);
+
+  EXPECT_THAT(myVec.get_capacity(), Eq(4));
+  EXPECT_THAT(myVec.at(0), Eq(2));
+}
+
+// Tracks how many instances are alive, to check that the ring only
+// constructs elements on push and destroys them on pop/clear.
+struct LiveCounter {
+  static int live;
+  int value;
+
+  LiveCounter(int value) : value(value) {
+    live++;
+  }
+  LiveCounter(const LiveCounter &other) : value(other.value) {
+    live++;
+  }
+  LiveCounter &operator=(const LiveCounter &other) = default;
+  ~LiveCounter() {
+    live--;
+  }
+};
+int LiveCounter::live = 0;
+
+// Owns heap memory but is safe to relocate with memcpy.
+struct Relocatable {
+  shared_ptr<int> ptr;
+};
+template <>
+struct is_trivially_relocatable<Relocatable> : true_type {};
+
+TEST(CircVectorStorage, no_default_construction) {
+  LiveCounter::live = 0;
+  {
+    CircVector<LiveCounter> myVec(4);
+    EXPECT_THAT(LiveCounter::live, Eq(0));
+
+    myVec.push_back(LiveCounter(1));
+    myVec.push_back(LiveCounter(2));
+    myVec.push_front(LiveCounter(3));
+    EXPECT_THAT(LiveCounter::live, Eq(3));
+
+    myVec.pop_front();
+    EXPECT_THAT(LiveCounter::live, Eq(2));
+
+    myVec.clear();
+    EXPECT_THAT(LiveCounter::live, Eq(0));
+
+    myVec.push_back(LiveCounter(4));
+  }
+  EXPECT_THAT(LiveCounter::live, Eq(0));
+}
+
+TEST(CircVectorStorage, resize_non_trivial) {
+  LiveCounter::live = 0;
+  {
+    CircVector<LiveCounter> myVec(2);
+    myVec.push_back(LiveCounter(1));
+    myVec.push_front(LiveCounter(0));
+    myVec.push_back(LiveCounter(2));  // wrapped ring grows
+
+    EXPECT_THAT(LiveCounter::live, Eq(3));
+    EXPECT_THAT(myVec.at(0).value, Eq(0));
+    EXPECT_THAT(myVec.at(2).value, Eq(2));
+  }
+  EXPECT_THAT(LiveCounter::live, Eq(0));
+}
+
+// Move may throw, so resizes copy it; the copy throws once `copies_left`
+// runs out.
+struct ThrowingCopy {
+  static int live;
+  static int copies_left;
+  int value;
+
+  ThrowingCopy(int value) : value(value) {
+    live++;
+  }
+  ThrowingCopy(const ThrowingCopy &other) : value(other.value) {
+    if (copies_left-- == 0) {
+      throw runtime_error("copy failed");
+    }
+    live++;
+  }
+  ThrowingCopy(ThrowingCopy &&other) : value(other.value) {
+    other.value = -1;
+    live++;
+  }
+  ThrowingCopy &operator=(const ThrowingCopy &other) = default;
+  ~ThrowingCopy() {
+    live--;
+  }
+};
+int ThrowingCopy::live = 0;
+int ThrowingCopy::copies_left = 0;
+
+TEST(CircVectorStorage, resize_throwing_copy_keeps_ring) {
+  ThrowingCopy::live = 0;
+  {
+    CircVector<ThrowingCopy> myVec(4);
+    myVec.emplace_back(1);
+    myVec.emplace_back(2);
+    myVec.emplace_front(0);
+    myVec.emplace_front(-5);  // wrapped and full
+
+    ThrowingCopy::copies_left = 2;
+    EXPECT_THROW(myVec.emplace_back(3), runtime_error);
+    EXPECT_THAT(ThrowingCopy::live, Eq(4));
+    EXPECT_THAT(myVec.get_capacity(), Eq(4));
+    EXPECT_THAT(myVec.at(0).value, Eq(-5));
+    EXPECT_THAT(myVec.at(3).value, Eq(2));
+
+    ThrowingCopy::copies_left = 100;
+    myVec.emplace_back(3);
+    EXPECT_THAT(myVec.at(4).value, Eq(3));
+  }
+  EXPECT_THAT(ThrowingCopy::live, Eq(0));
+}
+
+TEST(CircVectorStorage, resize_wrapped_trivially_copyable) {
+  CircVector<int> myVec(4);
+
+  myVec.push_back(2);
+  myVec.push_back(3);
+  myVec.push_front(1);
+  myVec.push_front(0);
+  myVec.push_back(4);
+
+  EXPECT_THAT(myVec.to_string(), StrEq("[0, 1, 2, 3, 4]"));
+}
+
+TEST(CircVectorStorage, copy_wrapped) {
+  CircVector<string> myVec(3);
+
+  myVec.push_back("b");
+  myVec.push_back("c");
+  myVec.push_front("a");
+
+  CircVector<string> myVec2(myVec);
+  CircVector<string> myVec3(1);
+  myVec3 = myVec;
+
+  EXPECT_THAT(myVec2.to_string(), StrEq("[a, b, c]"));
+  EXPECT_THAT(myVec3.to_string(), StrEq("[a, b, c]"));
+}
+
+TEST(CircVectorStorage, resize_trivially_relocatable) {
+  CircVector<Relocatable> myVec(2);
+
+  myVec.push_back(Relocatable{});
+  myVec.at(0).ptr = make_shared<int>(7);
+  myVec.push_back(Relocatable{});
+  myVec.at(1).ptr = make_shared<int>(8);
+  myVec.push_back(Relocatable{});
+
+  EXPECT_THAT(*myVec.at(0).ptr, Eq(7));
+  EXPECT_THAT(myVec.at(0).ptr.use_count(), Eq(1));
+  EXPECT_THAT(*myVec.at(1).ptr, Eq(8));
+}
+
+TEST(CircVectorMove, push_move_only) {
+  CircVector<unique_ptr<int>> myVec(2);
+
+  myVec.push_back(make_unique<int>(1));
+  myVec.push_front(make_unique<int>(0));
+  myVec.push_back(make_unique<int>(2));  // resize with move-only elements
+
+  EXPECT_THAT(*myVec.pop_front(), Eq(0));
+  EXPECT_THAT(*myVec.pop_back(), Eq(2));
+  EXPECT_THAT(*myVec.at(0), Eq(1));
+}
+
+TEST(CircVectorMove, emplace) {
+  CircVector<pair<int, string>> myVec(2);
+
+  myVec.emplace_back(1, "b");
+  myVec.emplace_front(0, "a");
+  pair<int, string> &elem = myVec.emplace_after(0, 2, "c");
+
+  EXPECT_THAT(elem.second, StrEq("c"));
+  EXPECT_THAT(myVec.at(1).first, Eq(2));
+  EXPECT_THAT(myVec.at(2).second, StrEq("b"));
+}
+
+TEST(CircVectorMove, emplace_back_self_reference) {
+  CircVector<string> myVec(2);
+
+  myVec.push_back("a");
+  myVec.push_back("b");
+  myVec.push_back(myVec.at(0));  // full: the argument lives in the old buffer
+
+  EXPECT_THAT(myVec.to_string(), StrEq("[a, b, a]"));
+}
+
+TEST(CircVectorMove, move_constructor) {
+  CircVector<string> myVec(4);
+  myVec.push_back("a");
+  myVec.push_front("b");
+  string *buffer = myVec.get_data();
+
+  CircVector<string> myVec2(move(myVec));
+
+  EXPECT_THAT(myVec2.get_data(), Eq(buffer));
+  EXPECT_THAT(myVec2.to_string(), StrEq("[b, a]"));
+  EXPECT_THAT(myVec.size(), Eq(0));
+
+  // A moved-from vector is still usable.
+  myVec.push_back("c");
+  EXPECT_THAT(myVec.to_string(), StrEq("[c]"));
+}
+
+TEST(CircVectorMove, copy_from_moved_from) {
+  CircVector<int> myVec(4);
+  myVec.push_back(1);
+  CircVector<int> myVec2(move(myVec));
+
+  CircVector<int> copy(myVec);
+  EXPECT_THAT(copy.empty(), Eq(true));
+  CircVector<int> assigned(2);
+  assigned.push_back(5);
+  assigned = myVec;
+  EXPECT_THAT(assigned.empty(), Eq(true));
+
+  myVec.push_back(2);
+  copy.push_back(3);
+  EXPECT_THAT(myVec.to_string(), StrEq("[2]"));
+  EXPECT_THAT(copy.to_string(), StrEq("[3]"));
+}
+
+TEST(CircVectorMove, move_assignment) {
+  CircVector<string> myVec(4);
+  CircVector<string> myVec2(2);
+  myVec.push_back("a");
+  myVec2.push_back("z");
+
+  myVec2 = move(myVec);
+
+  EXPECT_THAT(myVec2.to_string(), StrEq("[a]"));
+  EXPECT_THAT(myVec.empty(), Eq(true));
+}
+
+TEST(CircVectorBulk, append) {
+  CircVector<int> myVec(4);
+  vector<int> elems = {2, 3, 4, 5, 6};
+
+  myVec.push_back(1);
+  myVec.push_front(0);
+  myVec.append(elems);
+
+  EXPECT_THAT(myVec.size(), Eq(7));
+  EXPECT_THAT(myVec.get_capacity(), Eq(8));
+  EXPECT_THAT(myVec.to_string(), StrEq("[0, 1, 2, 3, 4, 5, 6]"));
+}
+
+TEST(CircVectorBulk, append_wraps) {
+  CircVector<string> myVec(6);
+  vector<string> elems = {"c", "d", "e"};
+
+  myVec.push_back("x");
+  myVec.push_back("x");
+  myVec.push_back("x");
+  myVec.push_back("a");
+  myVec.push_back("b");
+  myVec.pop_front();
+  myVec.pop_front();
+  myVec.pop_front();
+  myVec.append(elems);  // runs past the end of the buffer without growing
+
+  EXPECT_THAT(myVec.get_capacity(), Eq(6));
+  EXPECT_THAT(myVec.to_string(), StrEq("[a, b, c, d, e]"));
+}
+
+TEST(CircVectorBulk, prepend) {
+  CircVector<int> myVec(8);
+  vector<int> elems = {0, 1, 2};
+
+  myVec.push_back(3);
+  myVec.push_back(4);
+  myVec.prepend(elems);
+
+  EXPECT_THAT(myVec.to_string(), StrEq("[0, 1, 2, 3, 4]"));
+  EXPECT_THAT(myVec.pop_front(), Eq(0));
+}
+
+TEST(CircVectorBulk, pop_front_n) {
+  CircVector<string> myVec(4);
+  vector<string> out(5);
+
+  myVec.push_back("b");
+  myVec.push_back("c");
+  myVec.push_front("a");
+
+  EXPECT_THAT(myVec.pop_front_n(out.data(), 2), Eq(2));
+  EXPECT_THAT(out[0], StrEq("a"));
+  EXPECT_THAT(out[1], StrEq("b"));
+  EXPECT_THAT(myVec.pop_front_n(out.data(), 5), Eq(1));
+  EXPECT_THAT(out[0], StrEq("c"));
+  EXPECT_THAT(myVec.empty(), Eq(true));
+}
+
+TEST(CircVectorBulk, pop_back_n) {
+  CircVector<int> myVec(4);
+  int out[3];
+
+  myVec.push_back(2);
+  myVec.push_back(3);
+  myVec.push_front(1);
+  myVec.push_front(0);
+
+  EXPECT_THAT(myVec.pop_back_n(out, 3), Eq(3));
+  EXPECT_THAT(out[0], Eq(1));
+  EXPECT_THAT(out[2], Eq(3));
+  EXPECT_THAT(myVec.to_string(), StrEq("[0]"));
+}
+
+static_assert(random_access_iterator<CircVector<int>::iterator>);
+static_assert(random_access_iterator<CircVector<int>::const_iterator>);
+static_assert(ranges::random_access_range<CircVector<int>>);
+
+TEST(CircVectorIterator, range_for) {
+  CircVector<int> myVec(4);
+  myVec.push_back(2);
+  myVec.push_back(3);
+  myVec.push_front(1);
+  myVec.push_front(0);
+
+  int expected = 0;
+  for (int elem : myVec) {
+    EXPECT_THAT(elem, Eq(expected));
+    expected++;
+  }
+  EXPECT_THAT(expected, Eq(4));
+}
+
+TEST(CircVectorIterator, sort_wrapped) {
+  CircVector<int> myVec(6);
+  myVec.push_back(5);
+  myVec.push_back(1);
+  myVec.push_back(4);
+  myVec.push_front(3);
+  myVec.push_front(0);
+  myVec.push_front(2);
+
+  sort(myVec.begin(), myVec.end());
+
+  EXPECT_THAT(myVec.to_string(), StrEq("[0, 1, 2, 3, 4, 5]"));
+}
+
+TEST(CircVectorIterator, algorithms) {
+  CircVector<int> myVec(4);
+  myVec.push_back(3);
+  myVec.push_back(4);
+  myVec.push_front(2);
+  myVec.push_front(1);
+  const CircVector<int> &constVec = myVec;
+
+  EXPECT_THAT(accumulate(constVec.begin(), constVec.end(), 0), Eq(10));
+  EXPECT_THAT(constVec.end() - constVec.begin(), Eq(4));
+  EXPECT_THAT(myVec.begin()[2], Eq(3));
+  EXPECT_THAT(*ranges::max_element(myVec), Eq(4));
+  EXPECT_THAT(ranges::find(myVec, 2) - myVec.begin(), Eq(1));
+}
+
+TEST(CircVectorIterator, as_spans_wrapped) {
+  CircVector<int> myVec(4);
+  myVec.push_back(2);
+  myVec.push_back(3);
+  myVec.push_front(1);
+  myVec.push_front(0);
+
+  auto [head, tail] = myVec.as_spans();
+
+  EXPECT_THAT(head.size(), Eq(2));
+  EXPECT_THAT(tail.size(), Eq(2));
+  EXPECT_THAT(head[0], Eq(0));
+  EXPECT_THAT(tail[1], Eq(3));
+}
+
+TEST(CircVectorIterator, as_spans_contiguous) {
+  CircVector<int> myVec(4);
+  myVec.push_back(1);
+  myVec.push_back(2);
+
+  auto [head, tail] = myVec.as_spans();
+  head[0] = 7;
+
+  EXPECT_THAT(head.size(), Eq(2));
+  EXPECT_THAT(tail.empty(), Eq(true));
+  EXPECT_THAT(myVec.at(0), Eq(7));
+}
+
+TEST(CircVectorInPlace, remove_at_front_side) {
+  CircVector<string> myVec(8);
+  for (string s : {"a", "b", "c", "d", "e", "f"}) {
+    myVec.push_back(s);
+  }
+  string *buffer = myVec.get_data();
+
+  myVec.remove_at(1);
+
+  EXPECT_THAT(myVec.get_data(), Eq(buffer));
+  EXPECT_THAT(myVec.get_capacity(), Eq(8));
+  EXPECT_THAT(myVec.to_string(), StrEq("[a, c, d, e, f]"));
+  EXPECT_THAT(&myVec.at(0), Eq(buffer + 1));  // the front moved up instead
+}
+
+TEST(CircVectorInPlace, remove_at_back_side) {
+  CircVector<int> myVec(4);
+  myVec.push_back(2);
+  myVec.push_back(3);
+  myVec.push_front(1);
+  myVec.push_front(0);
+
+  myVec.remove_at(2);
+  myVec.remove_at(2);
+
+  EXPECT_THAT(myVec.to_string(), StrEq("[0, 1]"));
+  EXPECT_THAT(&myVec.at(0), Eq(myVec.get_data() + 2));
+}
+
+TEST(CircVectorInPlace, insert_after_front_side) {
+  CircVector<string> myVec(8);
+  for (string s : {"a", "c", "d", "e", "f"}) {
+    myVec.push_back(s);
+  }
+  string *buffer = myVec.get_data();
+
+  myVec.insert_after(0, "b");
+
+  EXPECT_THAT(myVec.get_data(), Eq(buffer));
+  EXPECT_THAT(myVec.to_string(), StrEq("[a, b, c, d, e, f]"));
+  EXPECT_THAT(&myVec.at(0), Eq(buffer + 7));  // wrapped back past slot 0
+}
+
+TEST(CircVectorInPlace, insert_after_back_side) {
+  CircVector<int> myVec(6);
+  myVec.push_back(3);
+  myVec.push_back(5);
+  myVec.push_front(2);
+  myVec.push_front(1);
+  myVec.push_front(0);
+
+  myVec.insert_after(3, 4);
+  myVec.insert_after(5, 6);  // full: grows, then appends
+
+  EXPECT_THAT(myVec.to_string(), StrEq("[0, 1, 2, 3, 4, 5, 6]"));
+}
+
+TEST(CircVectorInPlace, insert_after_self_reference) {
+  CircVector<string> myVec(4);
+  myVec.push_back("a");
+  myVec.push_back("b");
+  myVec.push_back("c");
+
+  myVec.insert_after(0, myVec.at(1));
+  myVec.insert_after(3, myVec.at(0));
+
+  EXPECT_THAT(myVec.to_string(), StrEq("[a, b, b, c, a]"));
+}
+
+// Fills a ring of `total` elements whose front sits `offset` slots into the
+// buffer, so that the live range wraps around its end.
+template <typename T>
+static CircVector<T> wrapped_ring(size_t total, size_t offset) {
+  CircVector<T> myVec(total);
+  for (size_t i = 0; i < offset; i++) {
+    myVec.push_back(T{});
+  }
+  for (size_t i = 0; i < offset; i++) {
+    myVec.pop_front();
+  }
+  for (size_t i = 0; i < total; i++) {
+    myVec.push_back(static_cast<T>(i % 50));
+  }
+  return myVec;
+}
+
+TEST(CircVectorScan, find_across_wrap) {
+  CircVector<int> myVec = wrapped_ring<int>(200, 150);
+
+  EXPECT_THAT(myVec.find(7), Eq(7));
+  EXPECT_THAT(myVec.rfind(7), Eq(157));
+  EXPECT_THAT(myVec.count(7), Eq(4));
+  EXPECT_THAT(myVec.find(49), Eq(49));
+  EXPECT_THAT(myVec.find(50), Eq(-1));
+  EXPECT_THAT(myVec.rfind(50), Eq(-1));
+  EXPECT_THAT(myVec.contains(0), Eq(true));
+  EXPECT_THAT(myVec.contains(-3), Eq(false));
+}
+
+TEST(CircVectorScan, every_element_type) {
+  CircVector<char> chars = wrapped_ring<char>(300, 10);
+  CircVector<short> shorts = wrapped_ring<short>(300, 20);
+  CircVector<long long> longs = wrapped_ring<long long>(300, 30);
+  CircVector<float> floats = wrapped_ring<float>(300, 40);
+  CircVector<double> doubles = wrapped_ring<double>(300, 299);
+
+  EXPECT_THAT(chars.rfind(3), Eq(253));
+  EXPECT_THAT(shorts.count(3), Eq(6));
+  EXPECT_THAT(longs.find(42), Eq(42));
+  EXPECT_THAT(floats.rfind(0.0f), Eq(250));
+  EXPECT_THAT(doubles.count(12.0), Eq(6));
+}
+
+TEST(CircVectorScan, matches_scalar_everywhere) {
+  // Every length and alignment around the vector widths, against the
+  // scalar reference.
+  vector<int> data(100);
+  for (size_t i = 0; i < data.size(); i++) {
+    data[i] = i % 7;
+  }
+  for (size_t start = 0; start < 9; start++) {
+    for (size_t len = 0; start + len <= data.size(); len++) {
+      const int *p = data.data() + start;
+      ASSERT_THAT(scan_find(p, len, 6), Eq(scan_find_scalar(p, len, 6)));
+      ASSERT_THAT(scan_rfind(p, len, 0), Eq(scan_rfind_scalar(p, len, 0)));
+      ASSERT_THAT(scan_count(p, len, 3), Eq(scan_count_scalar(p, len, 3)));
+#ifdef SIMDSCAN_X86
+      // The dispatcher picks one of these; check the other one too.
+      ASSERT_THAT(scan_find_sse2(p, len, 6), Eq(scan_find_scalar(p, len, 6)));
+      ASSERT_THAT(scan_rfind_sse2(p, len, 0),
+                  Eq(scan_rfind_scalar(p, len, 0)));
+      ASSERT_THAT(scan_count_sse2(p, len, 3),
+                  Eq(scan_count_scalar(p, len, 3)));
+#endif
+    }
+  }
+}
+
+TEST(CircVectorScan, floating_point_equality) {
+  CircVector<double> myVec(40);
+  for (int i = 0; i < 40; i++) {
+    myVec.push_back(i == 20 ? -0.0 : nan(""));
+  }
+
+  EXPECT_THAT(myVec.find(nan("")), Eq(-1));
+  EXPECT_THAT(myVec.find(0.0), Eq(20));
+  EXPECT_THAT(myVec.count(0.0), Eq(1));
+}
+
+TEST(CircVectorScan, non_arithmetic) {
+  CircVector<string> myVec(4);
+  myVec.push_back("b");
+  myVec.push_back("a");
+  myVec.push_front("a");
+
+  EXPECT_THAT(myVec.find("a"), Eq(0));
+  EXPECT_THAT(myVec.rfind("a"), Eq(2));
+  EXPECT_THAT(myVec.count("a"), Eq(2));
+  EXPECT_THAT(myVec.contains("c"), Eq(false));
+}
+
+// Forwards to the default resource and counts live bytes, so tests can see
+// which memory a container used.
+class CountingResource : public pmr::memory_resource {
+ public:
+  size_t live_bytes = 0;
+  size_t allocations = 0;
+
+ private:
+  void *do_allocate(size_t bytes, size_t alignment) override {
+    this->live_bytes += bytes;
+    this->allocations++;
+    return pmr::new_delete_resource()->allocate(bytes, alignment);
+  }
+
+  void do_deallocate(void *ptr, size_t bytes, size_t alignment) override {
+    this->live_bytes -= bytes;
+    pmr::new_delete_resource()->deallocate(ptr, bytes, alignment);
+  }
+
+  bool do_is_equal(const pmr::memory_resource &other) const noexcept override {
+    return this == &other;
+  }
+};
+
+TEST(CircVectorAllocator, pmr_buffer_from_resource) {
+  CountingResource resource;
+  {
+    PmrCircVector<int, PowerOfTwoCapacity> vec(4, &resource);
+    for (int i = 0; i < 20; i++) {
+      vec.push_back(i);
+    }
+    EXPECT_THAT(vec.get_allocator().resource(), Eq(&resource));
+    EXPECT_THAT(resource.live_bytes, Eq(vec.get_capacity() * sizeof(int)));
+    EXPECT_THAT(vec.to_string(), StrEq("[0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, "
+                                       "11, 12, 13, 14, 15, 16, 17, 18, 19]"));
+  }
+  EXPECT_THAT(resource.live_bytes, Eq(0));
+}
+
+TEST(CircVectorAllocator, pmr_elements_share_resource) {
+  CountingResource resource;
+  {
+    PmrCircVector<pmr::string> vec(&resource);
+    vec.push_back("a string too long for the small string buffer");
+    vec.emplace_front("another string too long for the small buffer");
+
+    EXPECT_THAT(vec.at(0).get_allocator().resource(), Eq(&resource));
+    EXPECT_THAT(vec.at(1).get_allocator().resource(), Eq(&resource));
+    EXPECT_THAT(resource.allocations, Eq(3));
+  }
+  EXPECT_THAT(resource.live_bytes, Eq(0));
+}
+
+TEST(CircVectorAllocator, pmr_move_between_resources) {
+  CountingResource first;
+  CountingResource second;
+  PmrCircVector<int> source(&first);
+  PmrCircVector<int> target(&second);
+  source.push_back(1);
+  source.push_back(2);
+
+  // Different resources: the elements move, the buffer stays put.
+  target = move(source);
+  EXPECT_THAT(target.get_allocator().resource(), Eq(&second));
+  EXPECT_THAT(target.to_string(), StrEq("[1, 2]"));
+  EXPECT_THAT(source.empty(), Eq(true));
+
+  PmrCircVector<int> copy(target);
+  EXPECT_THAT(copy.get_allocator().resource(),
+              Eq(pmr::get_default_resource()));
+  EXPECT_THAT(copy.to_string(), StrEq("[1, 2]"));
+}
+
+TEST(CircVectorAllocator, huge_pages) {
+  // Below a huge page: plain heap memory.
+  CircVector<int, PowerOfTwoCapacity, HugePageAllocator<int>> small(16);
+  // 4 MiB: mapped, with huge pages if the system offers them.
+  CircVector<uint64_t, PowerOfTwoCapacity, HugePageAllocator<uint64_t>> large(
+      huge_page_size / sizeof(uint64_t) * 2);
+
+  for (uint64_t i = 0; i < large.get_capacity(); i++) {
+    large.push_back(i);
+  }
+  small.push_back(7);
+  large.pop_front();
+  large.push_back(large.get_capacity());
+
+  EXPECT_THAT(small.at(0), Eq(7));
+  EXPECT_THAT(large.at(0), Eq(1));
+  EXPECT_THAT(large.at(large.size() - 1), Eq(large.get_capacity()));
+  EXPECT_THAT(large.count(12345), Eq(1));
+}
+
+TEST(CircVectorCapacity, reserve) {
+  CircVector<int> vec(4);
+  vec.push_back(1);
+  vec.push_front(0);
+
+  vec.reserve(1000);
+  EXPECT_THAT(vec.get_capacity(), Eq(1000));
+  EXPECT_THAT(vec.to_string(), StrEq("[0, 1]"));
+
+  vec.reserve(10);  // never shrinks
+  EXPECT_THAT(vec.get_capacity(), Eq(1000));
+}
+
+TEST(CircVectorCapacity, shrink_to_fit) {
+  CircVector<string, PowerOfTwoCapacity> vec(64);
+  for (int i = 0; i < 40; i++) {
+    vec.push_back(std::to_string(i));
+  }
+  for (int i = 0; i < 35; i++) {
+    vec.pop_front();
+  }
+
+  vec.shrink_to_fit();
+  EXPECT_THAT(vec.get_capacity(), Eq(8));
+  EXPECT_THAT(vec.to_string(), StrEq("[35, 36, 37, 38, 39]"));
+
+  vec.clear();
+  vec.shrink_to_fit();
+  EXPECT_THAT(vec.get_capacity(), Eq(1));
+  vec.push_back("a");
+  vec.push_back("b");
+  EXPECT_THAT(vec.to_string(), StrEq("[a, b]"));
+}
+
+TEST(CircVectorCapacity, auto_shrink) {
+  CircVector<int, PowerOfTwoCapacity> vec(16);
+  vec.set_auto_shrink(0.25);
+  for (int i = 0; i < 1024; i++) {
+    vec.push_back(i);
+  }
+  EXPECT_THAT(vec.get_capacity(), Eq(1024));
+
+  // 255 of 1024 is under a quarter: halve once, to 512.
+  int out[1024];
+  vec.pop_front_n(out, 769);
+  EXPECT_THAT(vec.get_capacity(), Eq(512));
+  EXPECT_THAT(vec.at(0), Eq(769));
+
+  // Never below the initial capacity.
+  vec.clear();
+  EXPECT_THAT(vec.get_capacity(), Eq(16));
+}
+
+TEST(CircVectorCapacity, auto_shrink_hysteresis) {
+  CircVector<int, PowerOfTwoCapacity> vec(4);
+  vec.set_auto_shrink(0.25);
+  vec.reserve(8);
+  for (int i = 0; i < 64; i++) {
+    vec.push_back(i);
+  }
+
+  // Oscillate around the growth point: one growth, then no shrink and no
+  // regrowth.
+  for (int round = 0; round < 100; round++) {
+    vec.push_back(round);
+    vec.pop_front();
+    vec.pop_back();
+    vec.push_front(round);
+  }
+  EXPECT_THAT(vec.get_capacity(), Eq(128));
+
+  // Drains down to the reserved floor, not below.
+  while (vec.size() > 1) {
+    vec.pop_back();
+  }
+  EXPECT_THAT(vec.get_capacity(), Eq(8));
+}
+
+TEST(CircVectorCapacity, auto_shrink_on_every_removal) {
+  using Vec = CircVector<int, PowerOfTwoCapacity>;
+  auto filled = [] {
+    Vec vec(16);
+    vec.set_auto_shrink(0.25);
+    for (int i = 0; i < 256; i++) {
+      vec.push_back(i);
+    }
+    return vec;
+  };
+
+  Vec vec = filled();
+  vec.erase(10, 256);
+  EXPECT_THAT(vec.get_capacity(), Eq(32));
+  while (vec.size() > 3) {
+    vec.remove_at(1);
+  }
+  EXPECT_THAT(vec.get_capacity(), Eq(16));
+  EXPECT_THAT(vec.to_string(), StrEq("[0, 8, 9]"));
+
+  vec = filled();
+  vec.remove_if([](int elem) { return elem >= 16; });
+  EXPECT_THAT(vec.get_capacity(), Eq(64));
+
+  vec = filled();
+  for (int i = 16; i < 256; i++) {
+    vec.remove(i);
+  }
+  EXPECT_THAT(vec.get_capacity(), Eq(64));
+
+  vec = filled();
+  for (int i = 0; i < 5; i++) {
+    vec.remove_every_other();
+  }
+  EXPECT_THAT(vec.size(), Eq(8));
+  EXPECT_THAT(vec.get_capacity(), Eq(32));
+}
+
+// Copies and moves carry the auto-shrink settings, whether constructed or
+// assigned.
+TEST(CircVectorCapacity, auto_shrink_copied) {
+  CircVector<int, PowerOfTwoCapacity> source(4);
+  source.set_auto_shrink(0.25);
+  for (int i = 0; i < 64; i++) {
+    source.push_back(i);
+  }
+
+  CircVector<int, PowerOfTwoCapacity> assigned(4);
+  assigned = source;
+  CircVector<int, PowerOfTwoCapacity> moved(4);
+  moved = CircVector<int, PowerOfTwoCapacity>(source);
+  for (auto *vec : {&assigned, &moved}) {
+    vec->erase(2, 64);
+    EXPECT_THAT(vec->get_capacity(), Eq(8));
+  }
+}
+
+TEST(CircVectorCapacity, auto_shrink_threshold) {
+  CircVector<int> vec;
+  EXPECT_THROW(vec.set_auto_shrink(0.5), invalid_argument);
+  EXPECT_THROW(vec.set_auto_shrink(-1), invalid_argument);
+  EXPECT_NO_THROW(vec.set_auto_shrink(0));
+}
+
+TEST(CircVectorGrowth, policies) {
+  CircVector<int, ExactCapacity, allocator<int>, DoublingGrowth> doubling(8);
+  CircVector<int, ExactCapacity, allocator<int>, HalfAgainGrowth> half(8);
+  CircVector<int, ExactCapacity, allocator<int>, FixedGrowth<5>> fixed(8);
+  for (int i = 0; i < 9; i++) {
+    doubling.push_back(i);
+    half.push_back(i);
+    fixed.push_back(i);
+  }
+
+  EXPECT_THAT(doubling.get_capacity(), Eq(16));
+  EXPECT_THAT(half.get_capacity(), Eq(12));
+  EXPECT_THAT(fixed.get_capacity(), Eq(13));
+  EXPECT_THAT(fixed.to_string(), StrEq("[0, 1, 2, 3, 4, 5, 6, 7, 8]"));
+
+  // Bulk growth takes at least what the policy would.
+  int more[5] = {9, 10, 11, 12, 13};
+  half.append(span<const int>(more, 5));
+  EXPECT_THAT(half.get_capacity(), Eq(18));
+  fixed.prepend(span<const int>(more, 4));
+  EXPECT_THAT(fixed.get_capacity(), Eq(13));
+  fixed.prepend(span<const int>(more, 1));
+  EXPECT_THAT(fixed.get_capacity(), Eq(18));
+}
+
+// Fills a ring of `capacity` elements so that it wraps with `tail` elements
+// past the end of the buffer, then pushes one more to force growth, and
+// checks the order survived.
+template <typename Vec>
+void check_wrapped_growth(size_t capacity, size_t tail) {
+  Vec vec(capacity);
+  for (uint64_t i = 0; i < tail; i++) {
+    vec.push_back(i);
+  }
+  for (uint64_t i = 0; i < tail; i++) {
+    vec.pop_front();
+  }
+  for (uint64_t i = 0; i <= capacity; i++) {
+    vec.push_back(i);
+  }
+
+  EXPECT_THAT(vec.get_capacity(), Gt(capacity));
+  bool in_order = true;
+  for (uint64_t i = 0; i <= capacity; i++) {
+    in_order &= vec.at(i) == i;
+  }
+  EXPECT_THAT(in_order, Eq(true));
+}
+
+TEST(CircVectorGrowth, remap_wrapped) {
+  using Remapped = CircVector<uint64_t, ExactCapacity,
+                              HugePageAllocator<uint64_t>, HalfAgainGrowth>;
+  using RemappedPow2 =
+      CircVector<uint64_t, PowerOfTwoCapacity, HugePageAllocator<uint64_t>>;
+  size_t large = huge_page_size / sizeof(uint64_t) + 3;
+
+  // Short wrapped run: moved up past the old end.
+  check_wrapped_growth<Remapped>(large, 100);
+  // Long wrapped run: the front run moves to the new end instead.
+  check_wrapped_growth<Remapped>(large, large - 100);
+  // Not wrapped at all.
+  check_wrapped_growth<Remapped>(large, 0);
+  check_wrapped_growth<RemappedPow2>(huge_page_size / sizeof(uint64_t), 7);
+  // Below the mapping threshold the allocator copies instead.
+  check_wrapped_growth<Remapped>(100, 30);
+}
+
+using Window = CircVector<int, ExactCapacity, allocator<int>, OverwriteOnFull>;
+
+TEST(CircVectorOverwrite, push_back_drops_oldest) {
+  Window window(3);
+  for (int i = 0; i < 10; i++) {
+    window.push_back(i);
+  }
+
+  EXPECT_THAT(window.get_capacity(), Eq(3));
+  EXPECT_THAT(window.to_string(), StrEq("[7, 8, 9]"));
+  EXPECT_THAT(window.get_overwritten(), Eq(7));
+  EXPECT_THAT(window.pop_front(), Eq(7));
+}
+
+TEST(CircVectorOverwrite, push_front_drops_newest) {
+  Window window(3);
+  for (int i = 0; i < 5; i++) {
+    window.push_front(i);
+  }
+
+  EXPECT_THAT(window.to_string(), StrEq("[4, 3, 2]"));
+  EXPECT_THAT(window.get_overwritten(), Eq(2));
+
+  window.push_back(10);  // the front is now the oldest
+  EXPECT_THAT(window.to_string(), StrEq("[3, 2, 10]"));
+}
+
+TEST(CircVectorOverwrite, bulk_matches_single_pushes) {
+  vector<int> elems = {1, 2, 3, 4, 5, 6};
+  Window bulk(4);
+  Window single(4);
+  bulk.push_back(0);
+  single.push_back(0);
+
+  bulk.append(span<const int>(elems.data(), 2));
+  bulk.append(span<const int>(elems));
+  for (int i = 0; i < 2; i++) {
+    single.push_back(elems[i]);
+  }
+  for (int elem : elems) {
+    single.push_back(elem);
+  }
+  EXPECT_THAT(bulk.to_string(), StrEq(single.to_string()));
+  EXPECT_THAT(bulk.get_overwritten(), Eq(single.get_overwritten()));
+
+  bulk.prepend(span<const int>(elems.data(), 3));
+  for (int i = 2; i >= 0; i--) {
+    single.push_front(elems[i]);
+  }
+  EXPECT_THAT(bulk.to_string(), StrEq("[1, 2, 3, 3]"));
+  EXPECT_THAT(bulk.to_string(), StrEq(single.to_string()));
+  EXPECT_THAT(bulk.get_overwritten(), Eq(single.get_overwritten()));
+}
+
+// The capacity of a window is its length: resizing calls leave it alone.
+TEST(CircVectorOverwrite, keeps_window_size) {
+  Window window(100);
+  for (int i = 0; i < 3; i++) {
+    window.push_back(i);
+  }
+
+  window.shrink_to_fit();
+  window.reserve(200);
+  EXPECT_THAT(window.get_capacity(), Eq(100));
+  for (int i = 3; i < 13; i++) {
+    window.push_back(i);
+  }
+  EXPECT_THAT(window.size(), Eq(13));
+  EXPECT_THAT(window.get_overwritten(), Eq(0));
+
+  Window source(8);
+  for (int i = 0; i < 8; i++) {
+    source.push_back(i);
+  }
+  stringstream stream;
+  source.serialize(stream);
+  Window small(3);
+  small.deserialize(stream);
+  EXPECT_THAT(small.get_capacity(), Eq(3));
+  EXPECT_THAT(small.to_string(), StrEq("[5, 6, 7]"));
+}
+
+TEST(CircVectorOverwrite, never_allocates) {
+  CountingResource resource;
+  CircVector<pmr::string, PowerOfTwoCapacity,
+             pmr::polymorphic_allocator<pmr::string>, OverwriteOnFull>
+      window(4, &resource);
+  size_t allocations = resource.allocations;
+
+  for (int i = 0; i < 100; i++) {
+    window.emplace_back(1, 'a' + i % 26);
+  }
+  EXPECT_THAT(resource.allocations, Eq(allocations));
+  EXPECT_THAT(window.get_overwritten(), Eq(96));
+  EXPECT_THAT(window.at(3), StrEq("v"));
+
+  EXPECT_THROW(window.insert_after(0, "x"), length_error);
+  EXPECT_THAT(window.size(), Eq(4));
+}
+
+TEST(CircVectorErase, remove_if_across_wrap) {
+  CircVector<string> vec(8);
+  for (int i = 0; i < 5; i++) {
+    vec.push_back(std::to_string(i));
+  }
+  for (int i = 5; i < 10; i++) {
+    vec.push_front(std::to_string(i));
+  }
+
+  size_t removed =
+      vec.remove_if([](const string &elem) { return stoi(elem) % 3 == 0; });
+  EXPECT_THAT(removed, Eq(4));
+  EXPECT_THAT(vec.to_string(), StrEq("[8, 7, 5, 1, 2, 4]"));
+
+  EXPECT_THAT(vec.retain([](const string &elem) { return elem < "5"; }),
+              Eq(3));
+  EXPECT_THAT(vec.to_string(), StrEq("[1, 2, 4]"));
+}
+
+TEST(CircVectorErase, erase_range) {
+  CircVector<int> vec = wrapped_ring<int>(10, 6);
+
+  vec.erase(1, 3);  // front side is shorter
+  EXPECT_THAT(vec.to_string(), StrEq("[0, 3, 4, 5, 6, 7, 8, 9]"));
+  vec.erase(4, 7);  // back side is shorter
+  EXPECT_THAT(vec.to_string(), StrEq("[0, 3, 4, 5, 9]"));
+  vec.erase(2, 2);
+  EXPECT_THAT(vec.size(), Eq(5));
+  vec.erase(0, 5);
+  EXPECT_THAT(vec.empty(), Eq(true));
+
+  EXPECT_THROW(vec.erase(0, 1), out_of_range);
+}
+
+TEST(CircVectorErase, remove_every_other_across_wrap) {
+  CircVector<string> vec(6);
+  for (int i = 3; i < 6; i++) {
+    vec.push_back(std::to_string(i));
+  }
+  for (int i = 2; i >= 0; i--) {
+    vec.push_front(std::to_string(i));
+  }
+  vec.remove_every_other();
+  EXPECT_THAT(vec.to_string(), StrEq("[0, 2, 4]"));
+}
+
+// Removes every multiple of 3 from wrapped rings of many sizes and offsets,
+// and compares against std::remove.
+template <typename T>
+void check_remove(size_t size, size_t offset) {
+  CircVector<T> vec = wrapped_ring<T>(size, offset);
+  vector<T> expected(vec.begin(), vec.end());
+  T target = static_cast<T>(3);
+  for (T &elem : expected) {
+    elem = static_cast<T>(static_cast<int>(elem) % 4);
+  }
+  for (T &elem : vec) {
+    elem = static_cast<T>(static_cast<int>(elem) % 4);
+  }
+  expected.erase(std::remove(expected.begin(), expected.end(), target),
+                 expected.end());
+
+  size_t removed = vec.remove(target);
+  EXPECT_THAT(removed, Eq(size - expected.size()));
+  EXPECT_THAT(vector<T>(vec.begin(), vec.end()), ContainerEq(expected));
+}
+
+TEST(CircVectorErase, simd_remove_matches_scalar) {
+  for (size_t size : {1, 7, 31, 64, 100}) {
+    for (size_t offset : {0, 3, 50}) {
+      check_remove<int8_t>(size, offset);
+      check_remove<int16_t>(size, offset);
+      check_remove<uint32_t>(size, offset);
+      check_remove<int64_t>(size, offset);
+      check_remove<float>(size, offset);
+      check_remove<double>(size, offset);
+    }
+  }
+}
+
+TEST(CircVectorErase, remove_all_and_none) {
+  CircVector<int> vec = wrapped_ring<int>(40, 20);
+  EXPECT_THAT(vec.remove(-1), Eq(0));
+  EXPECT_THAT(vec.size(), Eq(40));
+  for (int &elem : vec) {
+    elem = 7;
+  }
+  EXPECT_THAT(vec.remove(7), Eq(40));
+  EXPECT_THAT(vec.empty(), Eq(true));
+  vec.push_back(1);
+  EXPECT_THAT(vec.to_string(), StrEq("[1]"));
+}
+
+// Checks that format_to produces exactly to_string's text, and fails
+// cleanly when the buffer is one byte short.
+template <typename Vec>
+void check_format(const Vec &vec) {
+  string expected = vec.to_string();
+  char buffer[512];
+  to_chars_result result = vec.format_to(buffer, buffer + sizeof(buffer));
+  ASSERT_THAT(result.ec, Eq(errc()));
+  EXPECT_THAT(string(buffer, result.ptr), StrEq(expected));
+
+  result = vec.format_to(buffer, buffer + expected.size() - 1);
+  EXPECT_THAT(result.ec, Eq(errc::value_too_large));
+}
+
+TEST(CircVectorSerialize, format_matches_to_string) {
+  CircVector<double> doubles = wrapped_ring<double>(6, 3);
+  doubles.push_back(1.0 / 3);
+  doubles.push_back(-2.5e-7);
+  doubles.push_back(123456789.0);
+  doubles.push_back(1e300 * 1e10);
+  check_format(doubles);
+
+  CircVector<char> chars;
+  chars.push_back('a');
+  chars.push_back('z');
+  check_format(chars);
+
+  CircVector<int64_t> ints = wrapped_ring<int64_t>(5, 2);
+  ints.push_front(INT64_MIN);
+  check_format(ints);
+
+  CircVector<string> strings;
+  strings.push_back("x");
+  strings.push_back("");
+  strings.push_back("yz");
+  check_format(strings);
+
+  CircVector<bool> bools;
+  bools.push_back(true);
+  bools.push_back(false);
+  check_format(bools);
+
+  CircVector<int> empty;
+  check_format(empty);
+}
+
+TEST(CircVectorSerialize, round_trip_trivial) {
+  CircVector<uint32_t, PowerOfTwoCapacity> vec;
+  for (uint32_t i = 0; i < 20; i++) {
+    vec.push_back(i * 1000003);
+  }
+  for (int i = 0; i < 5; i++) {
+    vec.pop_front();
+  }
+  vec.push_front(7);
+
+  stringstream stream;
+  vec.serialize(stream);
+  EXPECT_THAT(stream.str().size(), Eq(8 + 16 * sizeof(uint32_t)));
+  // Little-endian size prefix.
+  EXPECT_THAT(stream.str()[0], Eq(16));
+
+  CircVector<uint32_t, PowerOfTwoCapacity> copy(2);
+  copy.push_back(99);
+  copy.deserialize(stream);
+  EXPECT_THAT(copy.to_string(), StrEq(vec.to_string()));
+}
+
+TEST(CircVectorSerialize, round_trip_strings) {
+  CircVector<string> vec(3);
+  vec.push_back("alpha");
+  vec.push_back("");
+  vec.push_front("gamma delta");
+
+  stringstream stream;
+  vec.serialize(stream);
+  CircVector<string> copy;
+  copy.deserialize(stream);
+  EXPECT_THAT(copy.to_string(), StrEq("[gamma delta, alpha, ]"));
+
+  stringstream truncated(stream.str().substr(0, 12));
+  EXPECT_THROW(copy.deserialize(truncated), runtime_error);
+}
+
+TEST(CircVectorInline, stays_inline_until_outgrown) {
+  CountingResource resource;
+  using Small = CircVector<int, ExactCapacity, pmr::polymorphic_allocator<int>,
+                           DoublingGrowth, 16>;
+  Small vec(&resource);
+
+  EXPECT_THAT(vec.get_capacity(), Eq(16));
+  for (int i = 0; i < 16; i++) {
+    vec.push_back(i);
+  }
+  vec.pop_front();
+  vec.push_back(16);
+  EXPECT_THAT(resource.allocations, Eq(0));
+
+  vec.push_back(17);  // outgrows the inline buffer
+  EXPECT_THAT(resource.allocations, Eq(1));
+  EXPECT_THAT(vec.get_capacity(), Eq(32));
+  EXPECT_THAT(vec.at(0), Eq(1));
+  EXPECT_THAT(vec.at(16), Eq(17));
+
+  // Shrinking back down moves into the inline buffer again.
+  int out[12];
+  vec.pop_front_n(out, 12);
+  vec.shrink_to_fit();
+  EXPECT_THAT(resource.live_bytes, Eq(0));
+  EXPECT_THAT(vec.to_string(), StrEq("[13, 14, 15, 16, 17]"));
+}
+
+TEST(CircVectorInline, shrink_keeps_inline_capacity) {
+  CountingResource resource;
+  using Small = CircVector<int, ExactCapacity, pmr::polymorphic_allocator<int>,
+                           DoublingGrowth, 16>;
+  Small vec(&resource);
+
+  // Already inline: shrinking has nowhere better to go.
+  vec.push_back(1);
+  vec.push_back(2);
+  vec.push_back(3);
+  vec.shrink_to_fit();
+  EXPECT_THAT(vec.get_capacity(), Eq(16));
+  EXPECT_THAT(resource.allocations, Eq(0));
+  EXPECT_THAT(vec.to_string(), StrEq("[1, 2, 3]"));
+
+  // A small capacity request still gets the whole inline buffer.
+  Small sized(3, &resource);
+  EXPECT_THAT(sized.get_capacity(), Eq(16));
+  EXPECT_THAT(resource.allocations, Eq(0));
+}
+
+TEST(CircVectorInline, regrows_inline_after_shrink) {
+  CountingResource resource;
+  using Small = CircVector<int, ExactCapacity, pmr::polymorphic_allocator<int>,
+                           DoublingGrowth, 16>;
+  Small vec(&resource);
+
+  for (int i = 0; i < 20; i++) {
+    vec.push_back(i);
+  }
+  EXPECT_THAT(resource.allocations, Eq(1));
+  int out[17];
+  vec.pop_front_n(out, 17);
+  vec.shrink_to_fit();  // heap to inline, at the full inline capacity
+  EXPECT_THAT(vec.get_capacity(), Eq(16));
+  EXPECT_THAT(resource.live_bytes, Eq(0));
+
+  for (int i = 20; i < 33; i++) {
+    vec.push_back(i);  // 16 elements: all fit inline
+  }
+  EXPECT_THAT(resource.allocations, Eq(1));
+  EXPECT_THAT(vec.size(), Eq(16));
+  EXPECT_THAT(vec.at(0), Eq(17));
+  EXPECT_THAT(vec.at(15), Eq(32));
+}
+
+TEST(CircVectorInline, copy_and_move) {
+  SmallCircVector<string, 4> small;
+  small.push_back("a");
+  small.push_back("b");
+  small.push_front("z");
+
+  SmallCircVector<string, 4> copy(small);
+  EXPECT_THAT(copy.to_string(), StrEq("[z, a, b]"));
+  EXPECT_THAT(copy.get_data(), Ne(small.get_data()));
+
+  SmallCircVector<string, 4> moved(move(copy));
+  EXPECT_THAT(moved.to_string(), StrEq("[z, a, b]"));
+  EXPECT_THAT(copy.empty(), Eq(true));
+  copy.push_back("still usable");
+  EXPECT_THAT(copy.size(), Eq(1));
+
+  // Heap-backed into inline-backed and back.
+  SmallCircVector<string, 4> big;
+  for (int i = 0; i < 6; i++) {
+    big.push_back(std::to_string(i));
+  }
+  moved = big;
+  EXPECT_THAT(moved.to_string(), StrEq("[0, 1, 2, 3, 4, 5]"));
+  moved = move(small);
+  EXPECT_THAT(moved.to_string(), StrEq("[z, a, b]"));
+  EXPECT_THAT(moved.get_capacity(), Eq(4));
+  big = move(moved);
+  EXPECT_THAT(big.to_string(), StrEq("[z, a, b]"));
+  big.push_back("c");
+  big.push_back("d");
+  EXPECT_THAT(big.to_string(), StrEq("[z, a, b, c, d]"));
+}
+
+TEST(CircVectorInline, size) {
+  EXPECT_THAT(sizeof(SmallCircVector<int, 16>),
+              Ge(sizeof(CircVector<int>) + 16 * sizeof(int)));
+  static_assert(is_nothrow_move_constructible_v<SmallCircVector<int, 8>>);
+}
+
+TEST(CircVectorAccess, unchecked_access) {
+  CircVector<int> vec(4);
+  vec.push_back(2);
+  vec.push_back(3);
+  vec.push_front(1);
+  vec.push_front(0);  // wraps
+
+  for (size_t i = 0; i < vec.size(); i++) {
+    EXPECT_THAT(vec[i], Eq(i));
+  }
+  vec[1] = 10;
+  vec.front() = -1;
+  vec.back()++;
+  EXPECT_THAT(vec.to_string(), StrEq("[-1, 10, 2, 4]"));
+
+  const CircVector<int> &view = vec;
+  EXPECT_THAT(view.front(), Eq(-1));
+  EXPECT_THAT(view.back(), Eq(4));
+  EXPECT_THAT(view[2], Eq(2));
+  static_assert(noexcept(vec[0]) && noexcept(vec.front()) &&
+                noexcept(vec.back()) && noexcept(vec.size()));
+}
+
+TEST(CircVectorAccess, try_pop) {
+  CircVector<string> vec;
+  vec.push_back("a");
+  vec.push_back("b");
+
+  EXPECT_THAT(vec.try_pop_back(), Optional(StrEq("b")));
+  EXPECT_THAT(vec.try_pop_front(), Optional(StrEq("a")));
+  EXPECT_THAT(vec.try_pop_front(), Eq(nullopt));
+  EXPECT_THAT(vec.try_pop_back(), Eq(nullopt));
+}
+
+TEST(CircVectorAccess, checked_access_aborts) {
+  if constexpr (checked_access) {
+    CircVector<int> vec;
+    vec.push_back(1);
+
+    EXPECT_DEATH(vec[1], "out of range");
+    vec.pop_back();
+    EXPECT_DEATH(vec.front(), "empty");
+    EXPECT_DEATH(vec.back(), "empty");
+  }
+}
+
+template <typename T>
+using StatsVector =
+    CircVector<T, ExactCapacity, allocator<T>, DoublingGrowth, 0,
+               ContainerStats>;
+
+TEST(CircVectorStats, disabled_is_free) {
+  EXPECT_THAT(sizeof(CircVector<int>),
+              Eq(sizeof(StatsVector<int>) - sizeof(ContainerStats)));
+}
+
+TEST(CircVectorStats, counts_resizes) {
+  StatsVector<int> vec(4);
+  for (int i = 0; i < 10; i++) {
+    vec.push_back(i);
+  }
+  vec.at(3);
+
+  StatsSnapshot stats = vec.get_stats().snapshot();
+  EXPECT_THAT(stats.resizes, Eq(2));  // 4 -> 8 -> 16
+  EXPECT_THAT(stats.bytes_copied, Eq((4 + 8) * sizeof(int)));
+  EXPECT_THAT(stats.peak_capacity, Eq(16));
+  EXPECT_THAT(stats[StatsOp::push_back].samples, Eq(10));
+  EXPECT_THAT(stats[StatsOp::resize].samples, Eq(2));
+  EXPECT_THAT(stats[StatsOp::at].samples, Eq(1));
+  EXPECT_THAT(stats[StatsOp::pop_front].samples, Eq(0));
+
+  StatsVector<int> copy(vec);
+  EXPECT_THAT(copy.get_stats().snapshot().bytes_copied,
+              Eq(10 * sizeof(int)));
+
+  vec.get_stats().reset();
+  vec.pop_front();
+  stats = vec.get_stats().snapshot();
+  EXPECT_THAT(stats.resizes, Eq(0));
+  EXPECT_THAT(stats[StatsOp::pop_front].samples, Eq(1));
+  EXPECT_THAT(stats[StatsOp::push_back].samples, Eq(0));
+}
+
+// Below the mapping threshold the allocator would copy the whole buffer
+// anyway, so the ring grows the usual way instead of remapping.
+TEST(CircVectorStats, small_rings_do_not_remap) {
+  CircVector<uint64_t, ExactCapacity, HugePageAllocator<uint64_t>,
+             DoublingGrowth, 0, ContainerStats>
+      vec(100);
+  for (uint64_t i = 0; i < 100; i++) {
+    vec.push_back(i);
+  }
+  vec.pop_front();
+  vec.push_back(100);  // wrapped by one
+
+  vec.push_back(101);
+  StatsSnapshot stats = vec.get_stats().snapshot();
+  EXPECT_THAT(stats.resizes, Eq(1));
+  EXPECT_THAT(stats.bytes_copied, Eq(100 * sizeof(uint64_t)));
+  EXPECT_THAT(vec.front(), Eq(1));
+  EXPECT_THAT(vec.back(), Eq(101));
+}
+
+// Claims every buffer is mapped but copies on every `reallocate`, like
+// `HugePageAllocator` on a kernel that cannot remap huge pages.
+template <typename T>
+struct CopyingReallocator : allocator<T> {
+  static bool is_mapped(size_t) {
+    return true;
+  }
+
+  T *reallocate(T *ptr, size_t old_count, size_t new_count, bool *copied) {
+    T *fresh = this->allocate(new_count);
+    memcpy(fresh, ptr, min(old_count, new_count) * sizeof(T));
+    this->deallocate(ptr, old_count);
+    *copied = true;
+    return fresh;
+  }
+};
+
+TEST(CircVectorStats, counts_reallocate_copies) {
+  CircVector<uint64_t, ExactCapacity, CopyingReallocator<uint64_t>,
+             DoublingGrowth, 0, ContainerStats>
+      vec(8);
+  for (uint64_t i = 0; i < 16; i++) {
+    vec.push_back(i);
+  }
+  for (uint64_t i = 16; i < 19; i++) {
+    vec.pop_front();
+    vec.push_back(i);  // wraps the last 3 of the 16 slots
+  }
+
+  vec.push_back(19);
+  StatsSnapshot stats = vec.get_stats().snapshot();
+  EXPECT_THAT(stats.resizes, Eq(2));
+  // The whole buffer each time, plus the wrapped run the second time.
+  EXPECT_THAT(stats.bytes_copied, Eq((8 + 16 + 3) * sizeof(uint64_t)));
+  EXPECT_THAT(vec.front(), Eq(3));
+  EXPECT_THAT(vec.back(), Eq(19));
+  EXPECT_THAT(vec.size(), Eq(17));
+}
+
+// A remap copies whichever run closes the wrap: here the longer front run,
+// since the back run does not fit in the 16 new slots.
+TEST(CircVectorStats, counts_remapped_bytes) {
+  CircVector<uint64_t, ExactCapacity, HugePageAllocator<uint64_t>,
+             FixedGrowth<16>, 0, ContainerStats>
+      vec(huge_page_size / sizeof(uint64_t));
+  size_t capacity = vec.get_capacity();
+  size_t tail = 100;
+  for (uint64_t i = 0; i < capacity; i++) {
+    vec.push_back(i);
+  }
+  for (uint64_t i = 0; i < tail; i++) {
+    vec.pop_front();
+    vec.push_back(i);
+  }
+
+  vec.push_back(0);
+  StatsSnapshot stats = vec.get_stats().snapshot();
+  EXPECT_THAT(stats.resizes, Eq(1));
+  EXPECT_THAT(stats.bytes_copied, Eq((capacity - tail) * sizeof(uint64_t)));
+}
+
+TEST(CircVectorStats, dump) {
+  StatsVector<int> vec(2);
+  vec.push_back(1);
+  vec.push_back(2);
+  vec.push_back(3);
+
+  StatsSnapshot stats = vec.get_stats().snapshot();
+  EXPECT_THAT(stats.to_string(), HasSubstr("resizes 1\n"));
+  EXPECT_THAT(stats.to_string(), HasSubstr("push_back: 3 calls"));
+  EXPECT_THAT(stats.to_string(), Not(HasSubstr("pop_back")));
+  EXPECT_THAT(stats.to_json(),
+              StartsWith("{\"resizes\":1,\"bytes_copied\":8,"));
+  EXPECT_THAT(stats.to_json(), HasSubstr("\"push_back\":{\"samples\":3,"));
+  EXPECT_THAT(stats.to_json(), EndsWith("]}}}"));
+}
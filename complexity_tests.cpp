@@ -0,0 +1,407 @@
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "circvector.h"
+#include "linkedlist.h"
+
+using namespace std;
+using namespace testing;
+
+// Complexity regression harness. Each test runs one operation at growing N
+// and fits cost = c * N^k on a log-log scale, for three costs per call:
+// element operations (constructions, copies, moves, assignments,
+// comparisons and destructions of `Counted`), allocations through
+// `CountingAllocator`, and wall time. A test fails when any exponent
+// exceeds the documented bound, e.g. k = 0 for O(1) and k = 1 for O(N).
+//
+// The counts are exact, so they get a tight tolerance. Wall time catches
+// work the counts cannot see, like walking list nodes, but is noisy: the
+// test binary runs unoptimized under sanitizers, often on a shared host.
+// So its exponents are only printed, unless `COMPLEXITY_CHECK_TIME` is set
+// (to anything but 0), which checks them with a loose tolerance; a linear
+// walk where the bound is O(1) still misses it by far.
+
+namespace {
+
+struct OpCounts {
+  size_t element_ops = 0;
+  size_t allocations = 0;
+};
+
+OpCounts counts;
+
+// Element type that counts everything done to it.
+class Counted {
+ public:
+  int value;
+
+  Counted(int value) : value(value) {
+    counts.element_ops++;
+  }
+
+  Counted(const Counted &other) : value(other.value) {
+    counts.element_ops++;
+  }
+
+  Counted(Counted &&other) noexcept : value(other.value) {
+    counts.element_ops++;
+  }
+
+  Counted &operator=(const Counted &other) {
+    this->value = other.value;
+    counts.element_ops++;
+    return *this;
+  }
+
+  Counted &operator=(Counted &&other) noexcept {
+    this->value = other.value;
+    counts.element_ops++;
+    return *this;
+  }
+
+  ~Counted() {
+    counts.element_ops++;
+  }
+
+  bool operator==(const Counted &other) const {
+    counts.element_ops++;
+    return this->value == other.value;
+  }
+};
+
+// Allocator that counts allocations.
+template <typename T>
+class CountingAllocator {
+ public:
+  using value_type = T;
+
+  CountingAllocator() = default;
+
+  template <typename U>
+  CountingAllocator(const CountingAllocator<U> &) {
+  }
+
+  T *allocate(size_t count) {
+    counts.allocations++;
+    return allocator<T>().allocate(count);
+  }
+
+  void deallocate(T *ptr, size_t count) {
+    allocator<T>().deallocate(ptr, count);
+  }
+
+  template <typename U>
+  bool operator==(const CountingAllocator<U> &) const {
+    return true;
+  }
+};
+
+using Vec = CircVector<Counted, ExactCapacity, CountingAllocator<Counted>>;
+using List = LinkedList<Counted, CountingAllocator<Counted>>;
+
+// Fitted exponents of each cost.
+struct Growth {
+  double element_ops;
+  double allocations;
+  double time;
+};
+
+const vector<size_t> sizes = {1 << 10, 1 << 11, 1 << 12, 1 << 13,
+                               1 << 14, 1 << 15, 1 << 16};
+const int rounds = 5;
+const double count_tolerance = 0.15;
+const double time_tolerance = 0.75;
+
+// Least-squares slope of log(y) against log(x).
+double log_log_slope(const vector<double> &x, const vector<double> &y) {
+  double mean_x = 0;
+  double mean_y = 0;
+  for (size_t i = 0; i < x.size(); i++) {
+    mean_x += log(x[i]) / x.size();
+    mean_y += log(y[i]) / y.size();
+  }
+  double num = 0;
+  double den = 0;
+  for (size_t i = 0; i < x.size(); i++) {
+    num += (log(x[i]) - mean_x) * (log(y[i]) - mean_y);
+    den += (log(x[i]) - mean_x) * (log(x[i]) - mean_x);
+  }
+  return num / den;
+}
+
+// Fits the cost per call of an operation. `setup(n)` builds the input for
+// size `n`, untimed and uncounted; `run(input, n)` does the measured work
+// and returns how many calls it made. Each cost is the minimum over
+// `rounds` sweeps of every size, so a burst of load on the machine slows
+// all sizes of a sweep alike rather than skewing the slope.
+template <typename Setup, typename Run>
+Growth fit(Setup setup, Run run) {
+  vector<double> x(sizes.begin(), sizes.end());
+  vector<double> ops(sizes.size(), INFINITY);
+  vector<double> allocs(sizes.size(), INFINITY);
+  vector<double> nanos(sizes.size(), INFINITY);
+  for (int round = 0; round < rounds; round++) {
+    for (size_t i = 0; i < sizes.size(); i++) {
+      auto input = setup(sizes[i]);
+      counts = OpCounts();
+      auto start = chrono::steady_clock::now();
+      double calls = run(input, sizes[i]);
+      auto elapsed = chrono::steady_clock::now() - start;
+      // +1 keeps the logarithm finite for operations that cost nothing.
+      ops[i] = min(ops[i], counts.element_ops / calls + 1);
+      allocs[i] = min(allocs[i], counts.allocations / calls + 1);
+      nanos[i] = min(nanos[i],
+                     chrono::duration<double, nano>(elapsed).count() / calls);
+    }
+  }
+  return {log_log_slope(x, ops), log_log_slope(x, allocs),
+          log_log_slope(x, nanos)};
+}
+
+// Whether to check the wall-time exponents rather than only print them.
+bool check_time() {
+  const char *env = getenv("COMPLEXITY_CHECK_TIME");
+  return env != nullptr && *env != '\0' && strcmp(env, "0") != 0;
+}
+
+// Checks every exponent of `growth` against `bound`.
+void expect_bound(const Growth &growth, double bound) {
+  EXPECT_THAT(growth.element_ops, Le(bound + count_tolerance))
+      << "element operations grow faster than N^" << bound;
+  EXPECT_THAT(growth.allocations, Le(bound + count_tolerance))
+      << "allocations grow faster than N^" << bound;
+  if (check_time()) {
+    EXPECT_THAT(growth.time, Le(bound + time_tolerance))
+        << "time grows faster than N^" << bound;
+  } else {
+    cout << "[ Complexity ] time ~ N^" << growth.time << " (bound N^" << bound
+         << ")" << endl;
+  }
+}
+
+template <typename C>
+unique_ptr<C> filled(size_t n) {
+  auto c = make_unique<C>();
+  for (size_t i = 0; i < n; i++) {
+    c->push_back(Counted(i));
+  }
+  return c;
+}
+
+template <typename C>
+unique_ptr<C> empty_container(size_t) {
+  return make_unique<C>();
+}
+
+}  // namespace
+
+// The harness itself: an operation that is linear per call must fit k = 1.
+TEST(ComplexityHarness, detects_linear) {
+  Growth growth = fit(filled<Vec>, [](auto &vec, size_t) {
+    for (size_t i = 0; i < 4; i++) {
+      vec->find(Counted(-1));
+    }
+    return 4;
+  });
+
+  EXPECT_THAT(growth.element_ops, AllOf(Gt(0.85), Lt(1.15)));
+  if (check_time()) {
+    EXPECT_THAT(growth.time, Gt(0.5));
+  }
+}
+
+TEST(ComplexityCircVector, push_amortized_constant) {
+  expect_bound(fit(empty_container<Vec>,
+                   [](auto &vec, size_t n) {
+                     for (size_t i = 0; i < n; i++) {
+                       vec->push_back(Counted(i));
+                     }
+                     return n;
+                   }),
+               0);
+  expect_bound(fit(empty_container<Vec>,
+                   [](auto &vec, size_t n) {
+                     for (size_t i = 0; i < n; i++) {
+                       vec->push_front(Counted(i));
+                     }
+                     return n;
+                   }),
+               0);
+}
+
+TEST(ComplexityCircVector, pop_constant) {
+  expect_bound(fit(filled<Vec>,
+                   [](auto &vec, size_t n) {
+                     for (size_t i = 0; i < n; i++) {
+                       vec->pop_front();
+                     }
+                     return n;
+                   }),
+               0);
+  expect_bound(fit(filled<Vec>,
+                   [](auto &vec, size_t n) {
+                     for (size_t i = 0; i < n; i++) {
+                       vec->pop_back();
+                     }
+                     return n;
+                   }),
+               0);
+}
+
+TEST(ComplexityCircVector, at_constant) {
+  expect_bound(fit(filled<Vec>,
+                   [](auto &vec, size_t n) {
+                     for (size_t i = 0; i < n; i++) {
+                       vec->at(i);
+                     }
+                     return n;
+                   }),
+               0);
+}
+
+// Removing or inserting at either end shifts nothing and never
+// reallocates; in the middle it shifts half the ring.
+TEST(ComplexityCircVector, remove_insert_at_ends_constant) {
+  expect_bound(fit(filled<Vec>,
+                   [](auto &vec, size_t n) {
+                     for (size_t i = 0; i < n / 2; i++) {
+                       vec->remove_at(0);
+                       vec->remove_at(vec->size() - 1);
+                     }
+                     return n;
+                   }),
+               0);
+  expect_bound(fit(filled<Vec>,
+                   [](auto &vec, size_t n) {
+                     for (size_t i = 0; i < n / 2; i++) {
+                       vec->pop_back();  // room, so inserts do not resize
+                     }
+                     for (size_t i = 0; i < n / 4; i++) {
+                       vec->insert_after(0, Counted(i));
+                       vec->insert_after(vec->size() - 1, Counted(i));
+                     }
+                     return n / 2;
+                   }),
+               0);
+}
+
+TEST(ComplexityCircVector, remove_at_middle_linear) {
+  expect_bound(fit(filled<Vec>,
+                   [](auto &vec, size_t) {
+                     for (size_t i = 0; i < 8; i++) {
+                       vec->remove_at(vec->size() / 2);
+                     }
+                     return 8;
+                   }),
+               1);
+}
+
+TEST(ComplexityCircVector, whole_container_linear) {
+  expect_bound(fit(filled<Vec>,
+                   [](auto &vec, size_t) {
+                     Vec copy(*vec);
+                     return 1;
+                   }),
+               1);
+  expect_bound(fit(filled<Vec>,
+                   [](auto &vec, size_t) {
+                     vec->remove_every_other();
+                     return 1;
+                   }),
+               1);
+  expect_bound(fit(filled<Vec>,
+                   [](auto &vec, size_t) {
+                     vec->remove_if(
+                         [](const Counted &elem) { return elem.value % 3; });
+                     return 1;
+                   }),
+               1);
+  expect_bound(fit(filled<Vec>,
+                   [](auto &vec, size_t n) {
+                     vec->erase(n / 4, n / 2);
+                     return 1;
+                   }),
+               1);
+}
+
+TEST(ComplexityLinkedList, push_constant) {
+  expect_bound(fit(empty_container<List>,
+                   [](auto &list, size_t n) {
+                     for (size_t i = 0; i < n; i++) {
+                       list->push_back(Counted(i));
+                     }
+                     return n;
+                   }),
+               0);
+  expect_bound(fit(empty_container<List>,
+                   [](auto &list, size_t n) {
+                     for (size_t i = 0; i < n; i++) {
+                       list->push_front(Counted(i));
+                     }
+                     return n;
+                   }),
+               0);
+}
+
+TEST(ComplexityLinkedList, front_back_constant) {
+  expect_bound(fit(filled<List>,
+                   [](auto &list, size_t n) {
+                     for (size_t i = 0; i < n; i++) {
+                       list->pop_front();
+                     }
+                     return n;
+                   }),
+               0);
+  expect_bound(fit(filled<List>,
+                   [](auto &list, size_t n) {
+                     for (size_t i = 0; i < n; i++) {
+                       list->back().value++;
+                     }
+                     return n;
+                   }),
+               0);
+}
+
+// Singly linked: the new back has to be found from the front.
+TEST(ComplexityLinkedList, pop_back_linear) {
+  expect_bound(fit(filled<List>,
+                   [](auto &list, size_t) {
+                     for (size_t i = 0; i < 8; i++) {
+                       list->pop_back();
+                     }
+                     return 8;
+                   }),
+               1);
+}
+
+TEST(ComplexityLinkedList, whole_container_linear) {
+  expect_bound(fit(filled<List>,
+                   [](auto &list, size_t) {
+                     List copy(*list);
+                     return 1;
+                   }),
+               1);
+  expect_bound(fit(filled<List>,
+                   [](auto &list, size_t) {
+                     list->find(Counted(-1));
+                     return 1;
+                   }),
+               1);
+  expect_bound(fit(filled<List>,
+                   [](auto &list, size_t) {
+                     list->remove_every_other();
+                     return 1;
+                   }),
+               1);
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstddef>
+#include <thread>
+
+using namespace std;
+
+// Size of the unit the CPU shares between cores. Indices written by
+// different threads are kept this far apart to avoid false sharing.
+#if defined(__APPLE__) && defined(__aarch64__)
+inline constexpr size_t cache_line_size = 128;
+#else
+inline constexpr size_t cache_line_size = 64;
+#endif
+
+/**
+ * Tells the CPU the caller is in a spin-wait loop, so it can save power and
+ * give a sibling hyperthread the core.
+ */
+inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#elif defined(__aarch64__)
+  asm volatile("yield");
+#endif
+}
+
+/**
+ * Escalating wait for a contended retry loop: spins with `cpu_relax()`
+ * first, then yields the time slice. Once `spin()` returns false the caller
+ * has waited long enough and should park (block in the kernel) instead.
+ */
+class Backoff {
+ private:
+  static constexpr int relax_rounds = 64;
+  static constexpr int yield_rounds = 16;
+
+  int round;
+
+ public:
+  Backoff() {
+    this->round = 0;
+  }
+
+  /**
+   * Waits a little longer than last time. Returns false once spinning and
+   * yielding are exhausted.
+   */
+  bool spin() {
+    if (this->round < relax_rounds) {
+      cpu_relax();
+    } else if (this->round < relax_rounds + yield_rounds) {
+      this_thread::yield();
+    } else {
+      return false;
+    }
+    this->round++;
+    return true;
+  }
+
+  /**
+   * Starts over from the cheapest wait, e.g. after making progress.
+   */
+  void reset() {
+    this->round = 0;
+  }
+};
@@ -0,0 +1,86 @@
+// Compares CircVector growth policies, with and without in-place remapping,
+// on a ring that grows while wrapped (two pushes per pop, like a queue whose
+// producer outpaces its consumer). For each configuration reports the peak
+// resident set, the total time spent in growing pushes, and the worst
+// single growing push.
+//
+// Each configuration runs in a forked child so its peak RSS is its own.
+
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+
+#include "circvector.h"
+#include "hugepage_allocator.h"
+
+using namespace std;
+
+const size_t final_size = size_t(1) << 24;  // 128 MiB of uint64_t
+
+// Peak resident set of this process so far, in MiB.
+double peak_rss_mib() {
+  rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_maxrss / 1024.0;
+}
+
+template <typename Vec>
+void run(const char *name) {
+  fflush(stdout);
+  pid_t child = fork();
+  if (child != 0) {
+    waitpid(child, nullptr, 0);
+    return;
+  }
+
+  double base_rss = peak_rss_mib();
+  Vec vec(1024);
+  chrono::nanoseconds growing{0};
+  chrono::nanoseconds worst{0};
+  size_t resizes = 0;
+
+  for (uint64_t i = 0; vec.size() < final_size; i++) {
+    for (int push = 0; push < 2; push++) {
+      size_t capacity = vec.get_capacity();
+      auto start = chrono::steady_clock::now();
+      vec.push_back(i);
+      auto elapsed = chrono::steady_clock::now() - start;
+      if (vec.get_capacity() != capacity) {
+        growing += elapsed;
+        worst = max(worst, chrono::duration_cast<chrono::nanoseconds>(elapsed));
+        resizes++;
+      }
+    }
+    vec.pop_front();
+  }
+
+  printf("%-28s %4zu resizes  peak RSS %7.1f MiB  growing %8.2f ms  "
+         "worst %7.2f ms\n",
+         name, resizes, peak_rss_mib() - base_rss, growing.count() / 1e6,
+         worst.count() / 1e6);
+  fflush(stdout);
+  _exit(0);
+}
+
+template <typename Growth>
+using Heap = CircVector<uint64_t, ExactCapacity, allocator<uint64_t>, Growth>;
+
+template <typename Growth>
+using Remapped =
+    CircVector<uint64_t, ExactCapacity, HugePageAllocator<uint64_t>, Growth>;
+
+using Step = FixedGrowth<size_t(1) << 21>;
+
+int main() {
+  printf("growing a wrapped ring to %zu uint64_t\n", final_size);
+  run<Heap<DoublingGrowth>>("doubling");
+  run<Heap<HalfAgainGrowth>>("half again");
+  run<Heap<Step>>("fixed 2M");
+  run<Remapped<DoublingGrowth>>("doubling, mremap");
+  run<Remapped<HalfAgainGrowth>>("half again, mremap");
+  run<Remapped<Step>>("fixed 2M, mremap");
+}
@@ -0,0 +1,160 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <new>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+using namespace std;
+
+// Size of a transparent/explicit huge page on x86-64 and arm64 Linux.
+inline constexpr size_t huge_page_size = size_t(2) << 20;
+
+/**
+ * Allocator for large ring buffers. Requests of at least `huge_page_size`
+ * bytes are mapped directly and backed by huge pages, so a multi-GB
+ * `CircVector` needs far fewer TLB entries: first an explicit `MAP_HUGETLB`
+ * mapping from the reserved pool, and if the pool is empty or not
+ * configured, an ordinary mapping marked `MADV_HUGEPAGE` so the kernel
+ * backs it with transparent huge pages when it can. Smaller requests, and
+ * every request off Linux, go to `operator new`.
+ *
+ * `reallocate` lets `CircVector` grow a mapped ring in place: the kernel
+ * moves page table entries instead of the bytes, and the old and new
+ * buffers never exist side by side. Rings below `huge_page_size` are not
+ * mapped, so `CircVector` grows them the usual way (see `is_mapped`).
+ *
+ * Stateless: any two instances are interchangeable.
+ */
+template <typename T>
+class HugePageAllocator {
+ private:
+  // Rounds `bytes` up to a whole number of huge pages, as `MAP_HUGETLB`
+  // requires; `munmap` must be given the same length back.
+  static size_t mapping_length(size_t bytes) {
+    return (bytes + huge_page_size - 1) & ~(huge_page_size - 1);
+  }
+
+  static bool use_mapping(size_t bytes) {
+#if defined(__linux__)
+    return bytes >= huge_page_size;
+#else
+    return false;
+#endif
+  }
+
+ public:
+  using value_type = T;
+  using is_always_equal = true_type;
+
+  HugePageAllocator() = default;
+
+  template <typename U>
+  HugePageAllocator(const HugePageAllocator<U> &) {
+  }
+
+  /**
+   * Returns whether `allocate(count)` maps its storage, so that `reallocate`
+   * can move it to a mapped size without copying.
+   */
+  static bool is_mapped(size_t count) {
+    return use_mapping(count * sizeof(T));
+  }
+
+  /**
+   * Allocates uninitialized storage for `count` objects of type `T`. Throws
+   * `bad_alloc` if no memory is available.
+   */
+  T *allocate(size_t count) {
+    if (count > size_t(-1) / sizeof(T)) {
+      throw bad_array_new_length();
+    }
+    size_t bytes = count * sizeof(T);
+    if (!use_mapping(bytes)) {
+      return static_cast<T *>(::operator new(bytes, align_val_t(alignof(T))));
+    }
+
+#if defined(__linux__)
+    size_t length = mapping_length(bytes);
+    void *memory = MAP_FAILED;
+#if defined(MAP_HUGETLB)
+    memory = mmap(nullptr, length, PROT_READ | PROT_WRITE,
+                  MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+#endif
+    if (memory == MAP_FAILED) {
+      memory = mmap(nullptr, length, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      if (memory == MAP_FAILED) {
+        throw bad_alloc();
+      }
+#if defined(MADV_HUGEPAGE)
+      // Only a hint; without THP support the mapping stays on small pages.
+      madvise(memory, length, MADV_HUGEPAGE);
+#endif
+    }
+    return static_cast<T *>(memory);
+#endif
+  }
+
+  /**
+   * Releases storage from `allocate(count)`.
+   */
+  void deallocate(T *ptr, size_t count) {
+    size_t bytes = count * sizeof(T);
+    if (!use_mapping(bytes)) {
+      ::operator delete(ptr, bytes, align_val_t(alignof(T)));
+      return;
+    }
+
+#if defined(__linux__)
+    munmap(ptr, mapping_length(bytes));
+#endif
+  }
+
+  /**
+   * Resizes storage from `allocate(old_count)` to `new_count` objects and
+   * returns it, possibly at a new address. The bytes of the first
+   * `min(old_count, new_count)` objects are kept, so `T` must be trivially
+   * relocatable. When both sizes are mapped, `mremap` moves or extends the
+   * pages without copying, unless the kernel cannot remap `MAP_HUGETLB`
+   * pages; otherwise this copies into a new allocation. Sets `*copied`, if
+   * given, to whether it copied.
+   *
+   * If no memory is available, throws `bad_alloc` and leaves `ptr` intact.
+   */
+  T *reallocate(T *ptr, size_t old_count, size_t new_count,
+                bool *copied = nullptr) {
+    size_t old_bytes = old_count * sizeof(T);
+    size_t new_bytes = new_count * sizeof(T);
+#if defined(__linux__)
+    if (use_mapping(old_bytes) && use_mapping(new_bytes)) {
+      void *moved = mremap(ptr, mapping_length(old_bytes),
+                           mapping_length(new_bytes), MREMAP_MAYMOVE);
+      if (moved != MAP_FAILED) {
+        if (copied != nullptr) {
+          *copied = false;
+        }
+        return static_cast<T *>(moved);
+      }
+      // Older kernels cannot remap `MAP_HUGETLB` mappings; copy instead.
+    }
+#endif
+
+    T *fresh = allocate(new_count);
+    memcpy(static_cast<void *>(fresh), ptr, min(old_bytes, new_bytes));
+    deallocate(ptr, old_count);
+    if (copied != nullptr) {
+      *copied = true;
+    }
+    return fresh;
+  }
+
+  template <typename U>
+  bool operator==(const HugePageAllocator<U> &) const {
+    return true;
+  }
+};
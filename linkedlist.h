@@ -1,113 +1,224 @@
 #pragma once
 
 #include <iostream>
+#include <memory>
+#include <memory_resource>
+#include <optional>
 #include <sstream>
 #include <stdexcept>
 #include <string>
 
+#include "checks.h"
+#include "serialization.h"
+#include "stats.h"
+
 using namespace std;
 
-template <typename T>
+/**
+ * Singly linked list of `T`. `Stats` is the instrumentation policy (see
+ * `stats.h`); the default records nothing.
+ */
+template <typename T, typename Allocator = allocator<T>,
+          typename Stats = NoStats>
 class LinkedList {
  private:
   class Node {
    public:
-    T data;
     Node *next;
-
-    Node(T data) {
-      this->data = data;
-      this->next = nullptr;
+    // Left unconstructed by `Node`; `make_node` builds it through the
+    // element allocator so that allocator-aware elements get the list's
+    // memory resource.
+    union {
+      T data;
+    };
+
+    Node(Node *next) {
+      this->next = next;
     }
 
-    Node(T data, Node *next) {
-      this->data = data;
-      this->next = next;
+    ~Node() {
     }
   };
 
+  using alloc_traits = allocator_traits<Allocator>;
+  using node_allocator = typename alloc_traits::template rebind_alloc<Node>;
+  using node_traits = allocator_traits<node_allocator>;
+
   size_t list_size;
   Node *list_front;
+  Node *list_back;  // Last node, so pushes at the back need no walk
+  [[no_unique_address]] Allocator alloc;
+
+  // Not copied or moved with the elements: every `LinkedList` reports on
+  // itself. Mutable so that const accessors can be timed.
+  [[no_unique_address]] mutable Stats stats;
+
+  // Allocates a node linked to `next`, with its `T` constructed from `args`.
+  template <typename... Args>
+  Node *make_node(Node *next, Args &&...args) {
+    node_allocator nodes(this->alloc);
+    Node *node = node_traits::allocate(nodes, 1);
+    this->stats.on_node_allocation();
+    this->stats.on_capacity(this->list_size + 1);
+    construct_at(node, next);
+    try {
+      alloc_traits::construct(this->alloc, &node->data,
+                              forward<Args>(args)...);
+    } catch (...) {
+      destroy_at(node);
+      node_traits::deallocate(nodes, node, 1);
+      this->stats.on_node_free();
+      throw;
+    }
+    return node;
+  }
+
+  // Destroys the `T` in `node` and returns its memory to the allocator.
+  void free_node(Node *node) {
+    node_allocator nodes(this->alloc);
+    alloc_traits::destroy(this->alloc, &node->data);
+    destroy_at(node);
+    node_traits::deallocate(nodes, node, 1);
+    this->stats.on_node_free();
+  }
+
+  // Appends copies of the elements of `other`, in order, to this (empty)
+  // `LinkedList`.
+  void copy_from(const LinkedList &other) {
+    this->stats.on_copy(other.list_size * sizeof(T));
+    // Link each copy through the previous node's `next` field, so the
+    // element type does not need a default constructor for a dummy head.
+    Node **tail = &this->list_front;
+    Node *other_curr = other.list_front;
+
+    while (other_curr != nullptr) {
+      *tail = make_node(nullptr, other_curr->data);
+      this->list_back = *tail;
+      tail = &(*tail)->next;
+      this->list_size++;
+      other_curr = other_curr->next;
+    }
+  }
 
  public:
   /**
    * Default constructor. Creates an empty `LinkedList`.
    */
-  LinkedList() {
+  LinkedList() : LinkedList(Allocator()) {
+  }
+
+  /**
+   * Creates an empty `LinkedList` whose nodes come from the given allocator.
+   */
+  explicit LinkedList(const Allocator &alloc) : alloc(alloc) {
     this->list_size = 0;
     this->list_front = nullptr;
+    this->list_back = nullptr;
   }
 
   /**
    * Returns whether the `LinkedList` is empty (i.e. whether its
    * size is 0).
    */
-  bool empty() const {
+  bool empty() const noexcept {
     return this->list_size == 0;
   }
 
   /**
    * Returns the number of elements in the `LinkedList`.
    */
-  size_t size() const {
+  size_t size() const noexcept {
     return this->list_size;
   }
 
   /**
-   * Adds the given `T` to the front of the `LinkedList`.
+   * Constructs a `T` from `args` in a new node at the front of the
+   * `LinkedList`, and returns a reference to it.
    */
-  void push_front(T data) {
-    Node *newNode = new Node(data);
-    newNode->next = list_front;  
+  template <typename... Args>
+  T &emplace_front(Args &&...args) {
+    [[maybe_unused]] auto timer = this->stats.time(StatsOp::push_front);
+    Node *newNode = make_node(list_front, forward<Args>(args)...);
     list_front = newNode;
+    if (this->list_back == nullptr) {
+      this->list_back = newNode;
+    }
     this->list_size++;
+    return newNode->data;
   }
 
   /**
-   * Adds the given `T` to the back of the `LinkedList`.
+   * Constructs a `T` from `args` in a new node at the back of the
+   * `LinkedList`, and returns a reference to it. Runs in O(1) time.
    */
-  void push_back(T data) {
-    Node *newNode = new Node(data);
+  template <typename... Args>
+  T &emplace_back(Args &&...args) {
+    [[maybe_unused]] auto timer = this->stats.time(StatsOp::push_back);
+    Node *newNode = make_node(nullptr, forward<Args>(args)...);
     if (this->list_size == 0) {
       list_front = newNode;
-      this->list_size++;
-      return;
+    } else {
+      this->list_back->next = newNode;
     }
+    this->list_back = newNode;
+    this->list_size++;
+    return newNode->data;
+  }
 
-    Node *currptr = list_front;
-    while (currptr->next != nullptr) {
-      currptr = currptr->next;
-    }
+  /**
+   * Adds the given `T` to the front of the `LinkedList`.
+   */
+  void push_front(const T &data) {
+    emplace_front(data);
+  }
 
-    currptr->next = newNode;
-    this->list_size++;
+  void push_front(T &&data) {
+    emplace_front(move(data));
+  }
+
+  /**
+   * Adds the given `T` to the back of the `LinkedList`.
+   */
+  void push_back(const T &data) {
+    emplace_back(data);
+  }
+
+  void push_back(T &&data) {
+    emplace_back(move(data));
   }
 
   /**
-   * Removes the element at the front of the `LinkedList`.
+   * Removes the element at the front of the `LinkedList` and returns it by
+   * move.
    *
    * If the `LinkedList` is empty, throws a `runtime_error`.
    */
   T pop_front() {
+    [[maybe_unused]] auto timer = this->stats.time(StatsOp::pop_front);
     if (this->empty()) {
       throw runtime_error("operation can not be performed on empty list");
     }
 
     Node *temp = this->list_front;
     this->list_front = temp->next;
-    T data_to_remove = temp->data;
-    delete temp;
+    if (this->list_front == nullptr) {
+      this->list_back = nullptr;
+    }
+    T data_to_remove = move(temp->data);
+    free_node(temp);
     this->list_size--;
     return data_to_remove;
   }
 
   /**
-   * Removes the element at the back of the `LinkedList`.
+   * Removes the element at the back of the `LinkedList` and returns it by
+   * move. The list is singly linked, so finding the new back takes O(N)
+   * time.
    *
    * If the `LinkedList` is empty, throws a `runtime_error`.
    */
   T pop_back() {
-    T data;
+    [[maybe_unused]] auto timer = this->stats.time(StatsOp::pop_back);
     // If list is empty
     if (list_front == nullptr) {
       throw runtime_error("operation can not be performed on empty list");
@@ -115,9 +226,10 @@ class LinkedList {
 
     // If list only has one element
     if (list_front->next == nullptr) {
-      data = list_front->data;
-      delete list_front;
+      T data = move(list_front->data);
+      free_node(list_front);
       list_front = nullptr;
+      this->list_back = nullptr;
       this->list_size = 0;
       return data;
     }
@@ -132,13 +244,36 @@ class LinkedList {
     }
 
     // Set data at currptr
-    data = currptr->data;
-    delete currptr;
+    T data = move(currptr->data);
+    free_node(currptr);
     secondLastNode->next = nullptr;
+    this->list_back = secondLastNode;
     this->list_size--;
     return data;
   }
 
+  /**
+   * Removes the element at the front of the `LinkedList` and returns it, or
+   * returns nothing if the `LinkedList` is empty.
+   */
+  optional<T> try_pop_front() noexcept(is_nothrow_move_constructible_v<T>) {
+    if (this->list_front == nullptr) {
+      return nullopt;
+    }
+    return pop_front();
+  }
+
+  /**
+   * Removes the element at the back of the `LinkedList` and returns it, or
+   * returns nothing if the `LinkedList` is empty.
+   */
+  optional<T> try_pop_back() noexcept(is_nothrow_move_constructible_v<T>) {
+    if (this->list_front == nullptr) {
+      return nullopt;
+    }
+    return pop_back();
+  }
+
   /**
    * Empties the `LinkedList`, releasing all allocated memory, and resetting
    * member variables appropriately.
@@ -162,6 +297,7 @@ class LinkedList {
    * If the index is invalid, throws `out_of_range`.
    */
   T &at(size_t index) const {
+    [[maybe_unused]] auto timer = this->stats.time(StatsOp::at);
     if (index >= this->list_size) {
       throw out_of_range("index is out of range");
     }
@@ -174,32 +310,82 @@ class LinkedList {
     return currptr->data;
   }
 
+  /**
+   * Returns the element at the given index without bounds checking. With
+   * checked access on (see `checks.h`), an invalid index aborts instead.
+   * Still walks the list, so it runs in O(index) time.
+   */
+  T &operator[](size_t index) noexcept {
+    expects(index < this->list_size, "LinkedList index is out of range");
+    Node *currptr = this->list_front;
+    for (size_t i = 0; i < index; i++) {
+      currptr = currptr->next;
+    }
+    return currptr->data;
+  }
+
+  const T &operator[](size_t index) const noexcept {
+    return const_cast<LinkedList &>(*this)[index];
+  }
+
+  /**
+   * Returns the element at the front of the `LinkedList`, which must not be
+   * empty (checked only with checked access on).
+   */
+  T &front() noexcept {
+    expects(this->list_front != nullptr, "front() of empty LinkedList");
+    return this->list_front->data;
+  }
+
+  const T &front() const noexcept {
+    expects(this->list_front != nullptr, "front() of empty LinkedList");
+    return this->list_front->data;
+  }
+
+  /**
+   * Returns the element at the back of the `LinkedList`, which must not be
+   * empty (checked only with checked access on).
+   */
+  T &back() noexcept {
+    expects(this->list_back != nullptr, "back() of empty LinkedList");
+    return this->list_back->data;
+  }
+
+  const T &back() const noexcept {
+    expects(this->list_back != nullptr, "back() of empty LinkedList");
+    return this->list_back->data;
+  }
+
   /**
    * Copy constructor. Creates a deep copy of the given `LinkedList`.
    *
    * Must run in O(N) time.
    */
-  LinkedList(const LinkedList &other) {    
-
+  LinkedList(const LinkedList &other)
+      : alloc(alloc_traits::select_on_container_copy_construction(
+            other.alloc)) {
     this->list_front = nullptr;
+    this->list_back = nullptr;
     this->list_size = 0;
-
-    if (other.empty()) {
-      return;
+    try {
+      copy_from(other);
+    } catch (...) {
+      this->clear();
+      throw;
     }
+  }
 
-    Node *curr = new Node(T{}); 
-    Node *prev = curr ;
-    Node *other_curr = other.list_front; 
-
-    while (other_curr != nullptr) {
-      curr->next = new Node(other_curr->data);
-      curr = curr->next;
-      other_curr = other_curr->next;
-    }
-    this->list_front = prev->next;
+  /**
+   * Move constructor. Takes over the nodes of the given `LinkedList`, which
+   * is left empty. Runs in O(1) time.
+   */
+  LinkedList(LinkedList &&other) noexcept : alloc(move(other.alloc)) {
+    this->list_front = other.list_front;
+    this->list_back = other.list_back;
     this->list_size = other.list_size;
-    delete prev;
+    other.list_front = nullptr;
+    other.list_back = nullptr;
+    other.list_size = 0;
   }
 
   /**
@@ -214,25 +400,52 @@ class LinkedList {
       return *this;
     }
 
-    // If list is empty
-    if (other.list_front == nullptr) {
-      this->clear();
-      return *this;
+    // The old nodes go back to the allocator that made them.
+    this->clear();
+    if constexpr (alloc_traits::propagate_on_container_copy_assignment::value) {
+      this->alloc = other.alloc;
     }
 
-    this->clear();
+    copy_from(other);
+    return *this;
+  }
 
-    this->list_front = new Node(other.list_front->data);
-    Node *currptr = this->list_front;
-    Node *otherptr = other.list_front->next;
+  /**
+   * Move assignment operator. Releases the current nodes and takes over the
+   * nodes of the given `LinkedList`, which is left empty.
+   *
+   * If the allocators differ and do not propagate on move, the nodes cannot
+   * change hands; the elements are moved into new nodes instead.
+   */
+  LinkedList &operator=(LinkedList &&other) noexcept(
+      alloc_traits::propagate_on_container_move_assignment::value ||
+      alloc_traits::is_always_equal::value) {
+    if (this == &other) {
+      return *this;
+    }
 
-    while (otherptr != nullptr) {
-      currptr->next = new Node(otherptr->data);
-      currptr = currptr->next;
-      otherptr = otherptr->next;
+    this->clear();
+    if constexpr (alloc_traits::propagate_on_container_move_assignment::value) {
+      this->alloc = move(other.alloc);
+    } else if (this->alloc != other.alloc) {
+      Node **tail = &this->list_front;
+      for (Node *curr = other.list_front; curr != nullptr;
+           curr = curr->next) {
+        *tail = make_node(nullptr, move(curr->data));
+        this->list_back = *tail;
+        tail = &(*tail)->next;
+        this->list_size++;
+      }
+      other.clear();
+      return *this;
     }
-    this->list_size = other.size();
 
+    this->list_front = other.list_front;
+    this->list_back = other.list_back;
+    this->list_size = other.list_size;
+    other.list_front = nullptr;
+    other.list_back = nullptr;
+    other.list_size = 0;
     return *this;
   }
 
@@ -244,12 +457,10 @@ class LinkedList {
   string to_string() const {
     Node *currptr = this->list_front;
     stringstream oss;
-    string llString;
 
     oss << '[';
     while (currptr != nullptr) {
-      T nodeData = currptr->data;
-      oss << nodeData;
+      oss << currptr->data;
 
       if (currptr->next) {
         oss <<  ',';
@@ -262,6 +473,62 @@ class LinkedList {
     return oss.str();
   }
 
+  /**
+   * Writes the same text as `to_string()` into `[first, last)` and returns
+   * the end of it, like `to_chars`. Arithmetic and string elements are
+   * formatted without allocating (see `format_elem`). If the buffer is too
+   * small, returns `{last, errc::value_too_large}`.
+   */
+  to_chars_result format_to(char *first, char *last) const {
+    to_chars_result result = format_text(first, last, "[");
+    for (Node *currptr = this->list_front;
+         currptr != nullptr && result.ec == errc(); currptr = currptr->next) {
+      if (currptr != this->list_front) {
+        result = format_text(result.ptr, last, ", ");
+        if (result.ec != errc()) {
+          break;
+        }
+      }
+      result = format_elem(result.ptr, last, currptr->data);
+    }
+    if (result.ec != errc()) {
+      return result;
+    }
+    return format_text(result.ptr, last, "]");
+  }
+
+  /**
+   * Writes the `LinkedList` to `out` in the binary format of
+   * `serialization.h`: the size, then the elements front to back.
+   */
+  void serialize(ostream &out) const {
+    Serializer<uint64_t>::write(out, this->list_size);
+    for (Node *currptr = this->list_front; currptr != nullptr;
+         currptr = currptr->next) {
+      Serializer<T>::write(out, currptr->data);
+    }
+  }
+
+  /**
+   * Replaces the contents of the `LinkedList` with ones read from `in`, as
+   * written by `serialize`. Runs in O(N) time.
+   *
+   * If `in` ends early, throws `runtime_error`; the elements read so far are
+   * kept.
+   */
+  void deserialize(istream &in) {
+    size_t count = Serializer<uint64_t>::read(in);
+    this->clear();
+
+    Node **tail = &this->list_front;
+    for (size_t i = 0; i < count; i++) {
+      *tail = make_node(nullptr, Serializer<T>::read(in));
+      this->list_back = *tail;
+      tail = &(*tail)->next;
+      this->list_size++;
+    }
+  }
+
   /**
    * Searches the `LinkedList` for the first matching element, and returns its
    * index. If no match is found, returns "-1".
@@ -299,7 +566,10 @@ class LinkedList {
     if (index == 0) {
       Node *temp = this->list_front;
       this->list_front = this->list_front->next;
-      delete temp;
+      if (this->list_front == nullptr) {
+        this->list_back = nullptr;
+      }
+      free_node(temp);
       this->list_size--;
       return;
     }
@@ -317,47 +587,52 @@ class LinkedList {
 
     if (currptr != nullptr) {
       prevptr->next = currptr->next;
-      delete currptr;
+      if (currptr == this->list_back) {
+        this->list_back = prevptr;
+      }
+      free_node(currptr);
       this->list_size--;
     }
   }
 
   /**
-   * Inserts the given `T` as a new element in the `LinkedList` after
-   * the given index. If the index is invalid, throws `out_of_range`.
+   * Constructs a `T` from `args` in a new node after the given index, and
+   * returns a reference to it. If the index is invalid, throws
+   * `out_of_range`.
    */
-  void insert_after(size_t index, T data) {
-    if (index > this->list_size) {
-      throw out_of_range("index is out of range");
+  template <typename... Args>
+  T &emplace_after(size_t index, Args &&...args) {
+    if (this->list_size == 0) {
+      throw out_of_range("Cannot insert after on an empty list");
     }
-
-    if (this->list_size == 0 && index == 0) {
-        throw out_of_range("Cannot insert after on an empty list");
+    if (index >= this->list_size) {
+      throw out_of_range("index is out of range");
     }
 
-    Node *newNode = new Node(data);
     Node *currptr = this->list_front;
-
-    if (index == 0){
-      if(currptr == nullptr) {
-        this->list_front = newNode;
-        newNode->next = nullptr;
-      }
-      else {
-    newNode->next = currptr->next;
-    currptr->next = newNode;
-      }
-    this->list_size++;
-      return;
-    }
-
-    for (int i = 0; i < index; i++) {
+    for (size_t i = 0; i < index; i++) {
       currptr = currptr->next;
     }
 
-    newNode->next = currptr->next;
+    Node *newNode = make_node(currptr->next, forward<Args>(args)...);
     currptr->next = newNode;
+    if (currptr == this->list_back) {
+      this->list_back = newNode;
+    }
     this->list_size++;
+    return newNode->data;
+  }
+
+  /**
+   * Inserts the given `T` as a new element in the `LinkedList` after
+   * the given index. If the index is invalid, throws `out_of_range`.
+   */
+  void insert_after(size_t index, const T &data) {
+    emplace_after(index, data);
+  }
+
+  void insert_after(size_t index, T &&data) {
+    emplace_after(index, move(data));
   }
 
   /**
@@ -377,7 +652,7 @@ class LinkedList {
 
     while (currptr != nullptr) {
       prevptr->next = currptr->next;
-      delete currptr;
+      free_node(currptr);
       currptr = prevptr->next;
 
       if (currptr != nullptr) {
@@ -386,13 +661,106 @@ class LinkedList {
       }
       this->list_size--;
     }
+    this->list_back = prevptr;
+  }
+
+  /**
+   * Removes every element for which `pred` returns true, keeping the order
+   * of the rest, and returns how many were removed. Unlinks in a single pass,
+   * so it runs in O(N) time.
+   */
+  template <typename Pred>
+  size_t remove_if(Pred pred) {
+    size_t removed = 0;
+    Node *kept = nullptr;  // Last node kept so far
+    Node **link = &this->list_front;
+    while (*link != nullptr) {
+      Node *currptr = *link;
+      if (pred(as_const(currptr->data))) {
+        *link = currptr->next;
+        free_node(currptr);
+        this->list_size--;
+        removed++;
+      } else {
+        kept = currptr;
+        link = &currptr->next;
+      }
+    }
+    this->list_back = kept;
+    return removed;
+  }
+
+  /**
+   * Keeps only the elements for which `pred` returns true. Returns how many
+   * were removed.
+   */
+  template <typename Pred>
+  size_t retain(Pred pred) {
+    return remove_if([&pred](const T &elem) { return !pred(elem); });
+  }
+
+  /**
+   * Removes every element equal to `value` and returns how many were
+   * removed.
+   */
+  size_t remove(const T &value) {
+    return remove_if([&value](const T &elem) { return elem == value; });
+  }
+
+  /**
+   * Removes the elements at indices `[first, last)`. Runs in O(last) time.
+   *
+   * If the range is invalid, throws `out_of_range`.
+   */
+  void erase(size_t first, size_t last) {
+    if (first > last || last > this->list_size) {
+      throw out_of_range("index is out of range");
+    }
+
+    Node *prevptr = nullptr;
+    Node **link = &this->list_front;
+    for (size_t i = 0; i < first; i++) {
+      prevptr = *link;
+      link = &(*link)->next;
+    }
+    for (size_t i = first; i < last; i++) {
+      Node *currptr = *link;
+      *link = currptr->next;
+      free_node(currptr);
+      this->list_size--;
+    }
+    if (*link == nullptr) {
+      this->list_back = prevptr;
+    }
+  }
+
+  /**
+   * Returns the instrumentation policy, e.g. to take a `snapshot()` of or
+   * `reset()` a `ContainerStats`.
+   */
+  Stats &get_stats() const noexcept {
+    return this->stats;
+  }
+
+  /**
+   * Returns a copy of the allocator the `LinkedList` gets its nodes from.
+   */
+  Allocator get_allocator() const {
+    return this->alloc;
   }
 
   /**
    * Returns a pointer to the node at the front of the `LinkedList`. For
    * autograder testing purposes only.
    */
-  void *front() const {
+  void *get_front_node() const noexcept {
     return this->list_front;
   }
 };
+
+/**
+ * `LinkedList` whose nodes, and the memory of allocator-aware elements such
+ * as `pmr::string`, come from a `pmr::memory_resource`.
+ */
+template <typename T>
+using PmrLinkedList = LinkedList<T, pmr::polymorphic_allocator<T>>;
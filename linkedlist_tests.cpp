@@ -1,6 +1,8 @@
 #include <gmock/gmock.h>  
 #include <gtest/gtest.h>
 
+#include <memory_resource>
+
 #include "linkedlist.h"
 
 using namespace std;
@@ -316,3 +318,268 @@ TEST(LinkedListExtras, Remove_Every_Other_Elements_empty) {
 
   EXPECT_THAT(myList.size(), Eq(0));
 }
+
+TEST(LinkedListMove, push_move_only) {
+  LinkedList<unique_ptr<int>> myList;
+
+  myList.push_back(make_unique<int>(1));
+  myList.push_front(make_unique<int>(0));
+  myList.push_back(make_unique<int>(2));
+
+  EXPECT_THAT(*myList.pop_front(), Eq(0));
+  EXPECT_THAT(*myList.pop_back(), Eq(2));
+  EXPECT_THAT(*myList.pop_back(), Eq(1));
+}
+
+TEST(LinkedListMove, emplace) {
+  LinkedList<pair<int, string>> myList;
+
+  myList.emplace_back(1, "b");
+  myList.emplace_front(0, "a");
+  pair<int, string> &elem = myList.emplace_after(1, 2, "c");
+
+  EXPECT_THAT(elem.second, StrEq("c"));
+  EXPECT_THAT(myList.at(2).first, Eq(2));
+  EXPECT_THAT(myList.size(), Eq(3));
+}
+
+TEST(LinkedListMove, move_constructor) {
+  LinkedList<string> myList;
+  myList.push_back("a");
+  myList.push_back("b");
+  void *front = myList.get_front_node();
+
+  LinkedList<string> myList2(move(myList));
+
+  EXPECT_THAT(myList2.get_front_node(), Eq(front));
+  EXPECT_THAT(myList2.to_string(), StrEq("[a, b]"));
+  EXPECT_THAT(myList.size(), Eq(0));
+}
+
+TEST(LinkedListMove, move_assignment) {
+  LinkedList<string> myList;
+  LinkedList<string> myList2;
+  myList.push_back("a");
+  myList2.push_back("z");
+
+  myList2 = move(myList);
+
+  EXPECT_THAT(myList2.to_string(), StrEq("[a]"));
+  EXPECT_THAT(myList.empty(), Eq(true));
+}
+
+TEST(LinkedListMove, copy_non_default_constructible) {
+  struct NoDefault {
+    int value;
+    NoDefault(int value) : value(value) {
+    }
+  };
+  LinkedList<NoDefault> myList;
+  myList.emplace_back(1);
+  myList.emplace_back(2);
+
+  LinkedList<NoDefault> myList2(myList);
+
+  EXPECT_THAT(myList2.at(1).value, Eq(2));
+}
+
+TEST(LinkedListAllocator, pmr_arena) {
+  // Nodes and strings all come from the arena, which frees them in one go.
+  char buffer[4096];
+  pmr::monotonic_buffer_resource arena(buffer, sizeof(buffer),
+                                       pmr::null_memory_resource());
+  PmrLinkedList<pmr::string> myList(&arena);
+
+  myList.push_back("a string too long for the small string buffer");
+  myList.emplace_front("b");
+  myList.emplace_after(0, "c");
+
+  EXPECT_THAT(myList.at(2).get_allocator().resource(), Eq(&arena));
+  EXPECT_THAT(myList.at(1), StrEq("c"));
+  EXPECT_THAT(myList.pop_front(), StrEq("b"));
+
+  PmrLinkedList<pmr::string> myList2(&arena);
+  myList2 = myList;
+  EXPECT_THAT(myList2.size(), Eq(2));
+  EXPECT_THAT(myList2.get_allocator().resource(), Eq(&arena));
+}
+
+TEST(LinkedListErase, remove_if_and_retain) {
+  LinkedList<int> myList;
+  for (int i = 0; i < 10; i++) {
+    myList.push_back(i);
+  }
+
+  EXPECT_THAT(myList.remove_if([](int elem) { return elem % 3 == 0; }),
+              Eq(4));
+  EXPECT_THAT(myList.to_string(), StrEq("[1, 2, 4, 5, 7, 8]"));
+  EXPECT_THAT(myList.retain([](int elem) { return elem > 4; }), Eq(3));
+  EXPECT_THAT(myList.to_string(), StrEq("[5, 7, 8]"));
+  EXPECT_THAT(myList.remove(7), Eq(1));
+  EXPECT_THAT(myList.to_string(), StrEq("[5, 8]"));
+  EXPECT_THAT(myList.size(), Eq(2));
+}
+
+TEST(LinkedListErase, erase_range) {
+  LinkedList<string> myList;
+  for (int i = 0; i < 6; i++) {
+    myList.push_back(std::to_string(i));
+  }
+
+  myList.erase(1, 3);
+  EXPECT_THAT(myList.to_string(), StrEq("[0, 3, 4, 5]"));
+  myList.erase(0, 1);
+  myList.erase(3, 3);
+  EXPECT_THAT(myList.to_string(), StrEq("[3, 4, 5]"));
+  myList.erase(1, 3);
+  EXPECT_THAT(myList.to_string(), StrEq("[3]"));
+  EXPECT_THROW(myList.erase(0, 2), out_of_range);
+  EXPECT_THAT(myList.size(), Eq(1));
+}
+
+TEST(LinkedListSerialize, format_and_round_trip) {
+  LinkedList<float> myList;
+  myList.push_back(0.1f);
+  myList.push_back(-3.0f);
+  myList.push_back(2.5e10f);
+
+  char buffer[64];
+  to_chars_result result = myList.format_to(buffer, buffer + sizeof(buffer));
+  EXPECT_THAT(string(buffer, result.ptr), StrEq(myList.to_string()));
+  EXPECT_THAT(myList.format_to(buffer, buffer + 5).ec,
+              Eq(errc::value_too_large));
+
+  stringstream stream;
+  myList.serialize(stream);
+  LinkedList<float> myList2;
+  myList2.push_back(9);
+  myList2.deserialize(stream);
+  EXPECT_THAT(myList2.to_string(), StrEq(myList.to_string()));
+  EXPECT_THAT(myList2.size(), Eq(3));
+}
+
+TEST(LinkedListAccess, unchecked_access) {
+  LinkedList<int> list;
+  list.push_back(1);
+  list.push_back(2);
+  list.push_front(0);
+
+  for (size_t i = 0; i < list.size(); i++) {
+    EXPECT_THAT(list[i], Eq(i));
+  }
+  list[1] = 10;
+  list.front() = -1;
+  list.back()++;
+  EXPECT_THAT(list.to_string(), StrEq("[-1, 10, 3]"));
+
+  const LinkedList<int> &view = list;
+  EXPECT_THAT(view.front(), Eq(-1));
+  EXPECT_THAT(view.back(), Eq(3));
+  EXPECT_THAT(view[1], Eq(10));
+  static_assert(noexcept(list[0]) && noexcept(list.front()) &&
+                noexcept(list.back()) && noexcept(list.try_pop_front()));
+}
+
+TEST(LinkedListAccess, try_pop) {
+  LinkedList<string> list;
+  list.push_back("a");
+  list.push_back("b");
+  list.push_back("c");
+
+  EXPECT_THAT(list.try_pop_back(), Optional(StrEq("c")));
+  EXPECT_THAT(list.try_pop_front(), Optional(StrEq("a")));
+  EXPECT_THAT(list.try_pop_back(), Optional(StrEq("b")));
+  EXPECT_THAT(list.try_pop_front(), Eq(nullopt));
+  EXPECT_THAT(list.try_pop_back(), Eq(nullopt));
+}
+
+TEST(LinkedListAccess, checked_access_aborts) {
+  if constexpr (checked_access) {
+    LinkedList<int> list;
+    list.push_back(1);
+
+    EXPECT_DEATH(list[1], "out of range");
+    list.pop_back();
+    EXPECT_DEATH(list.front(), "empty");
+    EXPECT_DEATH(list.back(), "empty");
+  }
+}
+
+TEST(LinkedListStats, disabled_is_free) {
+  EXPECT_THAT(sizeof(LinkedList<int>),
+              Eq(sizeof(size_t) + 2 * sizeof(void *)));
+}
+
+TEST(LinkedListStats, counts_nodes) {
+  LinkedList<string, allocator<string>, ContainerStats> list;
+  list.push_back("a");
+  list.push_back("b");
+  list.push_front("c");
+  list.at(2);
+  list.pop_back();
+
+  StatsSnapshot stats = list.get_stats().snapshot();
+  EXPECT_THAT(stats.node_allocations, Eq(3));
+  EXPECT_THAT(stats.node_frees, Eq(1));
+  EXPECT_THAT(stats.peak_capacity, Eq(3));
+  EXPECT_THAT(stats.resizes, Eq(0));
+  EXPECT_THAT(stats[StatsOp::push_back].samples, Eq(2));
+  EXPECT_THAT(stats[StatsOp::push_front].samples, Eq(1));
+  EXPECT_THAT(stats[StatsOp::at].samples, Eq(1));
+
+  LinkedList<string, allocator<string>, ContainerStats> copy(list);
+  stats = copy.get_stats().snapshot();
+  EXPECT_THAT(stats.node_allocations, Eq(2));
+  EXPECT_THAT(stats.bytes_copied, Eq(2 * sizeof(string)));
+
+  list.get_stats().reset();
+  EXPECT_THAT(list.get_stats().snapshot().node_allocations, Eq(0));
+}
+
+// The back is tracked rather than found, so check it after every kind of
+// change, including pushing onto what each one leaves behind.
+TEST(LinkedListAccess, back_follows_changes) {
+  LinkedList<int> list;
+  auto check = [&list]() {
+    if (!list.empty()) {
+      ASSERT_THAT(list.back(), Eq(list.at(list.size() - 1)));
+    }
+    list.push_back(99);
+    ASSERT_THAT(list.at(list.size() - 1), Eq(99));
+    list.pop_back();
+  };
+
+  for (int i = 0; i < 8; i++) {
+    list.push_back(i);
+  }
+  check();
+  list.push_front(-1);
+  check();
+  list.pop_back();
+  check();
+  list.remove_at(list.size() - 1);
+  check();
+  list.insert_after(list.size() - 1, 42);
+  check();
+  list.remove_every_other();
+  check();
+  list.remove_if([](int x) { return x == 42; });
+  check();
+  list.erase(1, list.size());
+  check();
+  LinkedList<int> copy(list);
+  list = copy;
+  check();
+  list = move(copy);
+  check();
+  list.pop_front();
+  check();
+  list.clear();
+  check();
+  list.push_front(7);
+  check();
+  stringstream data;
+  list.serialize(data);
+  list.deserialize(data);
+  check();
+}
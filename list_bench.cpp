@@ -0,0 +1,786 @@
+// Google Benchmark suite for CircVector and LinkedList, each operation run
+// side by side with the standard containers that support it, for int,
+// double and string elements and sizes from 10 to 10^7.
+//
+// Benchmarks are named `<operation>/<container>/<element>/<size>`, so
+// `--benchmark_filter=push_back/.*/int` picks one comparison. `make
+// run_list_bench` also writes every result to list_bench.json.
+//
+// Operations that cost O(N) per element on a container (e.g. indexing a
+// linked list) stop at `quadratic_max_size` elements for it, so a full run
+// stays in minutes.
+//
+// Every public operation of CircVector and LinkedList has a case, except
+// ones with nothing of their own to measure: the O(1) accessors (`size`,
+// `empty`, `front`, `back`, `get_*`), `begin`/`end` and `as_spans` (which
+// `iterate` walks), `clear` and the constructors and moves (which every
+// refill runs), and `set_auto_shrink` (a setter; the shrinking itself runs
+// inside the pops).
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <deque>
+#include <forward_list>
+#include <list>
+#include <random>
+#include <span>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "circvector.h"
+#include "linkedlist.h"
+
+using namespace std;
+
+const size_t min_size = 10;
+const size_t max_size = 10'000'000;
+const size_t quadratic_max_size = 10'000;
+
+// Distinct values; strings are long enough to live on the heap.
+template <typename T>
+T make_value(size_t i) {
+  if constexpr (is_same_v<T, string>) {
+    return "a string too long for SSO #" + std::to_string(i);
+  } else {
+    return static_cast<T>(i);
+  }
+}
+
+template <typename C>
+constexpr bool is_ours = false;
+
+template <typename T>
+constexpr bool is_ours<CircVector<T>> = true;
+
+template <typename T>
+constexpr bool is_ours<LinkedList<T>> = true;
+
+template <typename C>
+constexpr bool is_linked_list = false;
+
+template <typename T>
+constexpr bool is_linked_list<LinkedList<T>> = true;
+
+// Fills `c` with `n` distinct values, at the back where it can push there.
+template <typename C>
+void fill_container(C &c, size_t n) {
+  using T = remove_cvref_t<decltype(c.front())>;
+  for (size_t i = 0; i < n; i++) {
+    if constexpr (requires { c.push_back(make_value<T>(i)); }) {
+      c.push_back(make_value<T>(i));
+    } else {
+      c.push_front(make_value<T>(i));
+    }
+  }
+}
+
+// Each benchmark takes the container size as its argument and reports
+// elements per second where it touches every element.
+
+template <typename C, typename T>
+void bench_push_back(benchmark::State &state) {
+  size_t n = state.range(0);
+  for (auto _ : state) {
+    C c;
+    for (size_t i = 0; i < n; i++) {
+      c.push_back(make_value<T>(i));
+    }
+    benchmark::DoNotOptimize(c);
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+
+template <typename C, typename T>
+void bench_push_front(benchmark::State &state) {
+  size_t n = state.range(0);
+  for (auto _ : state) {
+    C c;
+    for (size_t i = 0; i < n; i++) {
+      c.push_front(make_value<T>(i));
+    }
+    benchmark::DoNotOptimize(c);
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+
+template <typename C, typename T>
+void bench_pop_front(benchmark::State &state) {
+  size_t n = state.range(0);
+  for (auto _ : state) {
+    state.PauseTiming();
+    C c;
+    fill_container(c, n);
+    state.ResumeTiming();
+    for (size_t i = 0; i < n; i++) {
+      if constexpr (is_ours<C>) {
+        benchmark::DoNotOptimize(c.pop_front());
+      } else {
+        benchmark::DoNotOptimize(c.front());
+        c.pop_front();
+      }
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+
+template <typename C, typename T>
+void bench_pop_back(benchmark::State &state) {
+  size_t n = state.range(0);
+  for (auto _ : state) {
+    state.PauseTiming();
+    C c;
+    fill_container(c, n);
+    state.ResumeTiming();
+    for (size_t i = 0; i < n; i++) {
+      if constexpr (is_ours<C>) {
+        benchmark::DoNotOptimize(c.pop_back());
+      } else {
+        benchmark::DoNotOptimize(c.back());
+        c.pop_back();
+      }
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+
+// `n` lookups at random indices, through the bounds-checked `at`.
+template <typename C, typename T>
+void bench_at(benchmark::State &state) {
+  size_t n = state.range(0);
+  C c;
+  fill_container(c, n);
+  mt19937_64 rng(1);
+  vector<size_t> indices(n);
+  for (size_t &index : indices) {
+    index = rng() % n;
+  }
+  for (auto _ : state) {
+    for (size_t index : indices) {
+      benchmark::DoNotOptimize(c.at(index));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+
+// The same lookups through the unchecked `operator[]`.
+template <typename C, typename T>
+void bench_subscript(benchmark::State &state) {
+  size_t n = state.range(0);
+  C c;
+  fill_container(c, n);
+  mt19937_64 rng(1);
+  vector<size_t> indices(n);
+  for (size_t &index : indices) {
+    index = rng() % n;
+  }
+  for (auto _ : state) {
+    for (size_t index : indices) {
+      benchmark::DoNotOptimize(c[index]);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+
+// Visits every element in order: by iterator where there is one, by index
+// otherwise.
+template <typename C, typename T>
+void bench_iterate(benchmark::State &state) {
+  size_t n = state.range(0);
+  C c;
+  fill_container(c, n);
+  for (auto _ : state) {
+    if constexpr (requires { c.begin(); }) {
+      for (const T &elem : c) {
+        benchmark::DoNotOptimize(elem);
+      }
+    } else {
+      for (size_t i = 0; i < n; i++) {
+        benchmark::DoNotOptimize(c[i]);
+      }
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+
+// Scans the whole container for a value it does not hold.
+template <typename C, typename T>
+void bench_find(benchmark::State &state) {
+  size_t n = state.range(0);
+  C c;
+  fill_container(c, n);
+  T missing = make_value<T>(n);
+  for (auto _ : state) {
+    if constexpr (is_ours<C>) {
+      benchmark::DoNotOptimize(c.find(missing));
+    } else {
+      benchmark::DoNotOptimize(std::find(c.begin(), c.end(), missing));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+
+template <typename C, typename T>
+void bench_copy(benchmark::State &state) {
+  size_t n = state.range(0);
+  C c;
+  fill_container(c, n);
+  for (auto _ : state) {
+    C copy(c);
+    benchmark::DoNotOptimize(copy);
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+
+// Removes the middle element and inserts it back, so the size holds.
+template <typename C, typename T>
+void bench_remove_insert_middle(benchmark::State &state) {
+  size_t n = state.range(0);
+  C c;
+  fill_container(c, n);
+  size_t mid = n / 2;
+  for (auto _ : state) {
+    if constexpr (is_ours<C>) {
+      T elem = c.at(mid);
+      c.remove_at(mid);
+      c.insert_after(mid - 1, move(elem));
+    } else {
+      auto pos = next(c.begin(), mid);
+      T elem = move(*pos);
+      pos = c.erase(pos);
+      c.insert(pos, move(elem));
+    }
+  }
+}
+
+template <typename C, typename T>
+void bench_remove_every_other(benchmark::State &state) {
+  size_t n = state.range(0);
+  C c;
+  for (auto _ : state) {
+    state.PauseTiming();
+    c.clear();  // Outside the timed part, like the refill
+    fill_container(c, n);
+    state.ResumeTiming();
+    if constexpr (is_ours<C>) {
+      c.remove_every_other();
+    } else {
+      size_t i = 0;
+      erase_if(c, [&i](const T &) { return i++ % 2 == 1; });
+    }
+    benchmark::DoNotOptimize(c);
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+
+// Bulk append of `n` elements from a contiguous array.
+template <typename C, typename T>
+void bench_append(benchmark::State &state) {
+  size_t n = state.range(0);
+  vector<T> source;
+  for (size_t i = 0; i < n; i++) {
+    source.push_back(make_value<T>(i));
+  }
+  for (auto _ : state) {
+    C c;
+    if constexpr (is_ours<C>) {
+      c.append(span<const T>(source));
+    } else {
+      c.insert(c.end(), source.begin(), source.end());
+    }
+    benchmark::DoNotOptimize(c);
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+
+template <typename C, typename T>
+void bench_to_string(benchmark::State &state) {
+  size_t n = state.range(0);
+  C c;
+  fill_container(c, n);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(c.to_string());
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+
+template <typename C, typename T>
+void bench_serialize(benchmark::State &state) {
+  size_t n = state.range(0);
+  C c;
+  fill_container(c, n);
+  for (auto _ : state) {
+    stringstream out;
+    c.serialize(out);
+    benchmark::DoNotOptimize(out);
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+
+template <typename C, typename T>
+void bench_deserialize(benchmark::State &state) {
+  size_t n = state.range(0);
+  C c;
+  fill_container(c, n);
+  stringstream serialized;
+  c.serialize(serialized);
+  string bytes = serialized.str();
+  for (auto _ : state) {
+    state.PauseTiming();
+    stringstream in(bytes);
+    state.ResumeTiming();
+    c.deserialize(in);
+    benchmark::DoNotOptimize(c);
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+
+// Formats into a caller buffer, without the allocations of `to_string`.
+template <typename C, typename T>
+void bench_format_to(benchmark::State &state) {
+  size_t n = state.range(0);
+  C c;
+  fill_container(c, n);
+  vector<char> buffer(c.to_string().size());
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        c.format_to(buffer.data(), buffer.data() + buffer.size()));
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+
+// Builds each element in place: strings from a count and a character, so
+// no temporary is moved in.
+template <typename C, typename T, bool Front>
+void emplace(C &c, size_t i) {
+  if constexpr (Front && is_same_v<T, string>) {
+    c.emplace_front(40, 'a');
+  } else if constexpr (Front) {
+    c.emplace_front(static_cast<T>(i));
+  } else if constexpr (is_same_v<T, string>) {
+    c.emplace_back(40, 'a');
+  } else {
+    c.emplace_back(static_cast<T>(i));
+  }
+}
+
+template <typename C, typename T>
+void bench_emplace_back(benchmark::State &state) {
+  size_t n = state.range(0);
+  for (auto _ : state) {
+    C c;
+    for (size_t i = 0; i < n; i++) {
+      emplace<C, T, false>(c, i);
+    }
+    benchmark::DoNotOptimize(c);
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+
+template <typename C, typename T>
+void bench_emplace_front(benchmark::State &state) {
+  size_t n = state.range(0);
+  for (auto _ : state) {
+    C c;
+    for (size_t i = 0; i < n; i++) {
+      emplace<C, T, true>(c, i);
+    }
+    benchmark::DoNotOptimize(c);
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+
+// Bulk prepend of `n` elements from a contiguous array.
+template <typename C, typename T>
+void bench_prepend(benchmark::State &state) {
+  size_t n = state.range(0);
+  vector<T> source;
+  for (size_t i = 0; i < n; i++) {
+    source.push_back(make_value<T>(i));
+  }
+  for (auto _ : state) {
+    C c;
+    c.push_back(make_value<T>(n));
+    if constexpr (is_ours<C>) {
+      c.prepend(span<const T>(source));
+    } else {
+      c.insert(c.begin(), source.begin(), source.end());
+    }
+    benchmark::DoNotOptimize(c);
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+
+// Drains the container in batches of 64 into a caller array.
+template <typename C, typename T>
+void bench_pop_front_n(benchmark::State &state) {
+  size_t n = state.range(0);
+  vector<T> out(64);
+  for (auto _ : state) {
+    state.PauseTiming();
+    C c;
+    fill_container(c, n);
+    state.ResumeTiming();
+    while (c.pop_front_n(out.data(), out.size()) > 0) {
+      benchmark::DoNotOptimize(out.data());
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+
+template <typename C, typename T>
+void bench_pop_back_n(benchmark::State &state) {
+  size_t n = state.range(0);
+  vector<T> out(64);
+  for (auto _ : state) {
+    state.PauseTiming();
+    C c;
+    fill_container(c, n);
+    state.ResumeTiming();
+    while (c.pop_back_n(out.data(), out.size()) > 0) {
+      benchmark::DoNotOptimize(out.data());
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+
+// Drains the container through the `optional`-returning pops.
+template <typename C, typename T>
+void bench_try_pop_front(benchmark::State &state) {
+  size_t n = state.range(0);
+  for (auto _ : state) {
+    state.PauseTiming();
+    C c;
+    fill_container(c, n);
+    state.ResumeTiming();
+    while (optional<T> elem = c.try_pop_front()) {
+      benchmark::DoNotOptimize(elem);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+
+template <typename C, typename T>
+void bench_try_pop_back(benchmark::State &state) {
+  size_t n = state.range(0);
+  for (auto _ : state) {
+    state.PauseTiming();
+    C c;
+    fill_container(c, n);
+    state.ResumeTiming();
+    while (optional<T> elem = c.try_pop_back()) {
+      benchmark::DoNotOptimize(elem);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+
+// Scans the whole container from the back for a value it does not hold.
+template <typename C, typename T>
+void bench_rfind(benchmark::State &state) {
+  size_t n = state.range(0);
+  C c;
+  fill_container(c, n);
+  T missing = make_value<T>(n);
+  for (auto _ : state) {
+    if constexpr (is_ours<C>) {
+      benchmark::DoNotOptimize(c.rfind(missing));
+    } else {
+      benchmark::DoNotOptimize(std::find(c.rbegin(), c.rend(), missing));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+
+template <typename C, typename T>
+void bench_count(benchmark::State &state) {
+  size_t n = state.range(0);
+  C c;
+  fill_container(c, n);
+  T target = make_value<T>(n / 2);
+  for (auto _ : state) {
+    if constexpr (is_ours<C>) {
+      benchmark::DoNotOptimize(c.count(target));
+    } else {
+      benchmark::DoNotOptimize(std::count(c.begin(), c.end(), target));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+
+// Looks for a value it does not hold, so the scan never stops early.
+template <typename C, typename T>
+void bench_contains(benchmark::State &state) {
+  size_t n = state.range(0);
+  C c;
+  fill_container(c, n);
+  T missing = make_value<T>(n);
+  for (auto _ : state) {
+    if constexpr (is_ours<C>) {
+      benchmark::DoNotOptimize(c.contains(missing));
+    } else {
+      benchmark::DoNotOptimize(std::find(c.begin(), c.end(), missing) !=
+                               c.end());
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+
+// Removes every element equal to one value, which half of them hold.
+template <typename C, typename T>
+void bench_remove(benchmark::State &state) {
+  size_t n = state.range(0);
+  C c;
+  const T value = make_value<T>(0);
+  for (auto _ : state) {
+    state.PauseTiming();
+    c.clear();
+    for (size_t i = 0; i < n; i++) {
+      if constexpr (requires { c.push_back(value); }) {
+        c.push_back(make_value<T>(i % 2 == 0 ? 0 : i));
+      } else {
+        c.push_front(make_value<T>(i % 2 == 0 ? 0 : i));
+      }
+    }
+    state.ResumeTiming();
+    if constexpr (is_ours<C>) {
+      benchmark::DoNotOptimize(c.remove(value));
+    } else {
+      benchmark::DoNotOptimize(erase(c, value));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+
+// Drops the elements made from even values by predicate; `retain` keeps
+// them instead, so either way half the elements go.
+template <typename C, typename T, bool Retain>
+void bench_remove_if(benchmark::State &state) {
+  size_t n = state.range(0);
+  C c;
+  auto even = [](const T &elem) {
+    if constexpr (is_same_v<T, string>) {
+      return (elem.back() - '0') % 2 == 0;
+    } else {
+      return static_cast<size_t>(elem) % 2 == 0;
+    }
+  };
+  for (auto _ : state) {
+    state.PauseTiming();
+    c.clear();
+    fill_container(c, n);
+    state.ResumeTiming();
+    if constexpr (Retain) {
+      benchmark::DoNotOptimize(c.retain(even));
+    } else if constexpr (is_ours<C>) {
+      benchmark::DoNotOptimize(c.remove_if(even));
+    } else {
+      benchmark::DoNotOptimize(erase_if(c, even));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+
+// Erases the middle half of the container in one call.
+template <typename C, typename T>
+void bench_erase(benchmark::State &state) {
+  size_t n = state.range(0);
+  C c;
+  for (auto _ : state) {
+    state.PauseTiming();
+    c.clear();
+    fill_container(c, n);
+    state.ResumeTiming();
+    if constexpr (is_ours<C>) {
+      c.erase(n / 4, n - n / 4);
+    } else {
+      c.erase(next(c.begin(), n / 4), next(c.begin(), n - n / 4));
+    }
+    benchmark::DoNotOptimize(c);
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+
+// Inserts after the first element, or after the last one, and removes it
+// again, so the size holds.
+template <typename C, typename T, bool AtBack>
+void bench_insert_after_end(benchmark::State &state) {
+  size_t n = state.range(0);
+  C c;
+  fill_container(c, n);
+  size_t idx = AtBack ? n - 1 : 0;
+  const T value = make_value<T>(n);
+  for (auto _ : state) {
+    if constexpr (is_ours<C>) {
+      c.insert_after(idx, value);
+      c.remove_at(idx + 1);
+    } else {
+      auto pos = c.insert(next(c.begin(), idx + 1), value);
+      c.erase(pos);
+    }
+  }
+}
+
+// Grows the buffer to twice the size and shrinks it back.
+template <typename C, typename T>
+void bench_reserve_shrink(benchmark::State &state) {
+  size_t n = state.range(0);
+  C c;
+  fill_container(c, n);
+  for (auto _ : state) {
+    c.reserve(2 * n);
+    c.shrink_to_fit();
+    benchmark::DoNotOptimize(c);
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+
+using Function = void (*)(benchmark::State &);
+
+// Registers `function` as `<operation>/<container>/<element>`, over sizes
+// from `min_size` up to `limit` in steps of 10x.
+void add(const string &operation, const string &container,
+         const string &element, Function function, size_t limit) {
+  string name = operation + "/" + container + "/" + element;
+  benchmark::RegisterBenchmark(name.c_str(), function)
+      ->RangeMultiplier(10)
+      ->Range(min_size, limit)
+      ->Unit(benchmark::kMicrosecond);
+}
+
+template <typename C, typename T>
+void add_container(const string &container, const string &element) {
+  C c;
+  const T value = make_value<T>(0);
+  // `LinkedList` walks the list to find the new back or to reach an index.
+  size_t walk_limit = is_linked_list<C> ? quadratic_max_size : max_size;
+
+  if constexpr (requires { c.push_back(value); }) {
+    add("push_back", container, element, bench_push_back<C, T>, max_size);
+  }
+  if constexpr (requires { c.push_front(value); }) {
+    add("push_front", container, element, bench_push_front<C, T>, max_size);
+  }
+  if constexpr (requires { c.pop_front(); }) {
+    add("pop_front", container, element, bench_pop_front<C, T>, max_size);
+  }
+  if constexpr (requires { c.pop_back(); }) {
+    add("pop_back", container, element, bench_pop_back<C, T>, walk_limit);
+  }
+  if constexpr (requires { c.at(0); }) {
+    add("at", container, element, bench_at<C, T>, walk_limit);
+  }
+  if constexpr (requires { c[0]; }) {
+    add("subscript", container, element, bench_subscript<C, T>,
+        walk_limit);
+  }
+  if constexpr (requires { c.begin(); } || requires { c[0]; }) {
+    add("iterate", container, element, bench_iterate<C, T>, walk_limit);
+  }
+  if constexpr (is_ours<C> || requires { c.begin(); }) {
+    add("find", container, element, bench_find<C, T>, max_size);
+  }
+  add("copy", container, element, bench_copy<C, T>, max_size);
+  if constexpr (is_ours<C> || requires { c.insert(c.begin(), value); }) {
+    add("remove_insert_middle", container, element,
+        bench_remove_insert_middle<C, T>, max_size);
+  }
+  add("remove_every_other", container, element,
+      bench_remove_every_other<C, T>, max_size);
+  if constexpr (requires { c.append(span<const T>()); } ||
+                requires { c.insert(c.end(), &value, &value); }) {
+    add("append", container, element, bench_append<C, T>, max_size);
+  }
+  if constexpr (is_ours<C>) {
+    add("to_string", container, element, bench_to_string<C, T>, max_size);
+    add("format_to", container, element, bench_format_to<C, T>, max_size);
+    add("serialize", container, element, bench_serialize<C, T>, max_size);
+    add("deserialize", container, element, bench_deserialize<C, T>,
+        max_size);
+  }
+
+  if constexpr (requires { c.emplace_back(); }) {
+    add("emplace_back", container, element, bench_emplace_back<C, T>,
+        max_size);
+  }
+  if constexpr (requires { c.emplace_front(); }) {
+    add("emplace_front", container, element, bench_emplace_front<C, T>,
+        max_size);
+  }
+  if constexpr (requires { c.prepend(span<const T>()); } ||
+                (!is_ours<C> &&
+                 requires { c.insert(c.begin(), &value, &value); })) {
+    add("prepend", container, element, bench_prepend<C, T>, max_size);
+  }
+  if constexpr (requires { c.pop_front_n(nullptr, 0); }) {
+    add("pop_front_n", container, element, bench_pop_front_n<C, T>,
+        max_size);
+    add("pop_back_n", container, element, bench_pop_back_n<C, T>, max_size);
+  }
+  if constexpr (requires { c.try_pop_front(); }) {
+    add("try_pop_front", container, element, bench_try_pop_front<C, T>,
+        max_size);
+    add("try_pop_back", container, element, bench_try_pop_back<C, T>,
+        walk_limit);
+  }
+  if constexpr (requires { c.rfind(value); } ||
+                (!is_ours<C> && requires { c.rbegin(); })) {
+    add("rfind", container, element, bench_rfind<C, T>, max_size);
+  }
+  if constexpr (requires { c.count(value); } ||
+                (!is_ours<C> && requires { c.begin(); })) {
+    add("count", container, element, bench_count<C, T>, max_size);
+    add("contains", container, element, bench_contains<C, T>, max_size);
+  }
+  if constexpr (is_ours<C> || requires { erase(c, value); }) {
+    add("remove", container, element, bench_remove<C, T>, max_size);
+    add("remove_if", container, element, bench_remove_if<C, T, false>,
+        max_size);
+  }
+  if constexpr (is_ours<C>) {
+    add("retain", container, element, bench_remove_if<C, T, true>,
+        max_size);
+  }
+  if constexpr (is_ours<C> || requires { c.erase(c.begin(), c.end()); }) {
+    add("erase", container, element, bench_erase<C, T>, walk_limit);
+  }
+  if constexpr (is_ours<C> || requires { c.insert(c.begin(), value); }) {
+    add("insert_after_front", container, element,
+        bench_insert_after_end<C, T, false>, max_size);
+    add("insert_after_back", container, element,
+        bench_insert_after_end<C, T, true>, walk_limit);
+  }
+  if constexpr (requires {
+                  c.reserve(0);
+                  c.shrink_to_fit();
+                }) {
+    add("reserve_shrink", container, element, bench_reserve_shrink<C, T>,
+        max_size);
+  }
+}
+
+template <typename T>
+void add_element(const string &element) {
+  add_container<CircVector<T>, T>("CircVector", element);
+  add_container<LinkedList<T>, T>("LinkedList", element);
+  add_container<deque<T>, T>("deque", element);
+  add_container<vector<T>, T>("vector", element);
+  add_container<list<T>, T>("list", element);
+  add_container<forward_list<T>, T>("forward_list", element);
+}
+
+int main(int argc, char **argv) {
+  add_element<int>("int");
+  add_element<double>("double");
+  add_element<string>("string");
+
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+}
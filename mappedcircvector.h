@@ -0,0 +1,565 @@
+#pragma once
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cerrno>
+#include <compare>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+
+#include "circvector.h"
+#include "simdscan.h"
+
+using namespace std;
+
+/**
+ * `CircVector` whose ring lives in a memory-mapped file, so a process can
+ * reopen it after a restart without rebuilding it. Elements must be
+ * trivially copyable, since they are stored as raw bytes.
+ *
+ * The file starts with a one-page header, followed by the slots. The header
+ * keeps two copies of the ring state (capacity, front index and size) and
+ * the index of the live one. Every change writes the element slots first,
+ * then the idle copy of the state, and publishes it by flipping the index
+ * with a single 8-byte store. A process that dies at any point therefore
+ * leaves either the old or the new state in the file, never a mix. A new
+ * file is built under a temporary name (`<path>.tmp.<pid>`) and renamed
+ * into place once its header is on disk, so `path` never names a file
+ * without one; a crash during creation may leave the temporary file behind.
+ *
+ * Supports the operations that touch only the ends of the ring, plus
+ * lookups and iteration. `insert_after` and `remove_at` are left out on
+ * purpose: they shift elements through live slots, which a crash midway
+ * would leave half done under the old state.
+ *
+ * Against power loss, only the state of the last completed `sync()` is
+ * durable; `sync()` flushes the slots before the header. Between syncs the
+ * kernel writes pages back whenever it likes, possibly the header before
+ * the slots it refers to, so un-synced changes may survive partially. Pass
+ * `sync_every` to sync after every that many changes.
+ *
+ * A full ring doubles, by extending the file and remapping it in place
+ * (`mremap`); only the shorter run of a wrapped ring is copied, into the
+ * new space, so the old state stays valid until the new one is published.
+ */
+template <typename T, typename CapacityPolicy = ExactCapacity>
+class MappedCircVector {
+  static_assert(is_trivially_copyable_v<T>,
+                "MappedCircVector stores elements as raw bytes");
+
+ private:
+  static constexpr uint64_t file_magic = 0x3143455643524943;  // "CIRCVEC1"
+
+  struct State {
+    uint64_t capacity;
+    uint64_t front_idx;
+    uint64_t size;
+  };
+
+  struct Header {
+    uint64_t magic;
+    uint64_t elem_size;
+    uint64_t data_offset;  // Bytes from the start of the file to slot 0
+    uint64_t live;         // Which of `states` is current
+    State states[2];
+  };
+
+  int fd;
+  char *base;  // Start of the mapping, i.e. the header
+  size_t mapped_length;
+  T *data;
+
+  // Cached copy of the live state.
+  size_t capacity;
+  size_t front_idx;
+  size_t vec_size;
+
+  size_t sync_every;
+  size_t unsynced;
+
+  Header *header() const {
+    return reinterpret_cast<Header *>(this->base);
+  }
+
+  size_t file_length(size_t capacity) const {
+    return this->header()->data_offset + capacity * sizeof(T);
+  }
+
+  size_t wrap(size_t index, size_t difference) const {
+    return CapacityPolicy::wrap(index + difference, this->capacity);
+  }
+
+  // Whether `state` describes a ring this class can index: its capacity is
+  // one the capacity policy produces (so `wrap` agrees with the policy that
+  // wrote the file), and the front and size lie within it and the file.
+  bool valid(const State &state) const {
+    size_t offset = this->header()->data_offset;
+    if (offset < sizeof(Header) || offset % alignof(T) != 0 ||
+        offset > this->mapped_length) {
+      return false;
+    }
+    return state.capacity > 0 &&
+           state.capacity <= (this->mapped_length - offset) / sizeof(T) &&
+           CapacityPolicy::round(state.capacity) == state.capacity &&
+           state.front_idx < state.capacity && state.size <= state.capacity;
+  }
+
+  // Random-access iterator over the logical order of the ring, by index
+  // like `CircVector::Iterator`. Writes through it reach the file but are
+  // not ordered with the header, as with `at`.
+  class Iterator {
+   private:
+    const MappedCircVector *vec;
+    size_t index;
+
+    friend class MappedCircVector;
+
+    Iterator(const MappedCircVector *vec, size_t index)
+        : vec(vec), index(index) {
+    }
+
+   public:
+    using iterator_concept = random_access_iterator_tag;
+    using iterator_category = random_access_iterator_tag;
+    using value_type = T;
+    using difference_type = ptrdiff_t;
+    using reference = T &;
+    using pointer = T *;
+
+    Iterator() : vec(nullptr), index(0) {
+    }
+
+    reference operator*() const {
+      return vec->data[vec->wrap(vec->front_idx, this->index)];
+    }
+
+    pointer operator->() const {
+      return &**this;
+    }
+
+    reference operator[](difference_type n) const {
+      return *(*this + n);
+    }
+
+    Iterator &operator++() {
+      this->index++;
+      return *this;
+    }
+
+    Iterator operator++(int) {
+      Iterator old = *this;
+      this->index++;
+      return old;
+    }
+
+    Iterator &operator--() {
+      this->index--;
+      return *this;
+    }
+
+    Iterator operator--(int) {
+      Iterator old = *this;
+      this->index--;
+      return old;
+    }
+
+    Iterator &operator+=(difference_type n) {
+      this->index += n;
+      return *this;
+    }
+
+    Iterator &operator-=(difference_type n) {
+      this->index -= n;
+      return *this;
+    }
+
+    friend Iterator operator+(Iterator it, difference_type n) {
+      return it += n;
+    }
+
+    friend Iterator operator+(difference_type n, Iterator it) {
+      return it += n;
+    }
+
+    friend Iterator operator-(Iterator it, difference_type n) {
+      return it -= n;
+    }
+
+    friend difference_type operator-(const Iterator &a, const Iterator &b) {
+      return static_cast<difference_type>(a.index - b.index);
+    }
+
+    friend bool operator==(const Iterator &a, const Iterator &b) {
+      return a.index == b.index;
+    }
+
+    friend strong_ordering operator<=>(const Iterator &a, const Iterator &b) {
+      return a.index <=> b.index;
+    }
+  };
+
+  [[noreturn]] static void fail(const char *what) {
+    throw system_error(errno, generic_category(), what);
+  }
+
+  // Builds an empty ring of `capacity` slots in a temporary file, flushes
+  // it and renames it to `path`. Leaves `fd` and the mapping set up.
+  void create(const string &path, size_t capacity) {
+    string temp = path + ".tmp." + std::to_string(getpid());
+    this->fd = open(temp.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (this->fd < 0) {
+      fail("open");
+    }
+    try {
+      size_t page = sysconf(_SC_PAGESIZE);
+      this->capacity = CapacityPolicy::round(capacity);
+      if (ftruncate(this->fd, page + this->capacity * sizeof(T)) != 0) {
+        fail("ftruncate");
+      }
+      map(page + this->capacity * sizeof(T));
+      *header() = {file_magic, sizeof(T), page, 0, {}};
+      this->front_idx = 0;
+      this->vec_size = 0;
+      publish();
+      sync();
+      if (rename(temp.c_str(), path.c_str()) != 0) {
+        fail("rename");
+      }
+    } catch (...) {
+      unlink(temp.c_str());
+      throw;
+    }
+  }
+
+  void map(size_t length) {
+    void *memory =
+        mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, this->fd, 0);
+    if (memory == MAP_FAILED) {
+      fail("mmap");
+    }
+    this->base = static_cast<char *>(memory);
+    this->mapped_length = length;
+  }
+
+  // Writes the cached state to the idle header copy and makes it the live
+  // one. The release store keeps every slot write before it in program
+  // order, so the file never shows a state whose elements are missing.
+  void publish() {
+    Header *head = this->header();
+    uint64_t next = 1 - head->live;
+    head->states[next] = {this->capacity, this->front_idx, this->vec_size};
+    atomic_ref<uint64_t>(head->live).store(next, memory_order_release);
+
+    if (this->sync_every != 0 && ++this->unsynced >= this->sync_every) {
+      sync();
+    }
+  }
+
+  // Doubles the ring by growing the file and the mapping.
+  void grow() {
+    size_t newCapacity = CapacityPolicy::round(this->capacity * 2);
+    size_t length = file_length(newCapacity);
+    if (ftruncate(this->fd, length) != 0) {
+      fail("ftruncate");
+    }
+    void *memory =
+        mremap(this->base, this->mapped_length, length, MREMAP_MAYMOVE);
+    if (memory == MAP_FAILED) {
+      fail("mremap");
+    }
+    this->base = static_cast<char *>(memory);
+    this->mapped_length = length;
+    this->data = reinterpret_cast<T *>(this->base + header()->data_offset);
+
+    // Lay a wrapped ring out again by copying its shorter run into the new
+    // slots. Doubling leaves room for either run there, so no live slot of
+    // the old state is overwritten before the new one is published.
+    size_t head = min(this->vec_size, this->capacity - this->front_idx);
+    size_t tail = this->vec_size - head;
+    if (tail > 0) {
+      if (tail <= head) {
+        memcpy(this->data + this->capacity, this->data, tail * sizeof(T));
+      } else {
+        size_t start = newCapacity - head;
+        memcpy(this->data + start, this->data + this->front_idx,
+               head * sizeof(T));
+        this->front_idx = start;
+      }
+    }
+    this->capacity = newCapacity;
+    publish();
+  }
+
+ public:
+  using iterator = Iterator;
+
+  /**
+   * Opens the ring stored at `path`, or creates it with the given capacity
+   * (rounded up by the capacity policy) if the file does not exist. When
+   * reopening, `capacity` is ignored. If `sync_every` is not 0, every that
+   * many changes are flushed to disk with `sync()`.
+   *
+   * If the file exists but does not hold a ring of `T`, holds a corrupt or
+   * truncated one, or was written with a capacity this capacity policy
+   * cannot produce, throws `runtime_error`; if a system call fails, throws
+   * `system_error`.
+   */
+  MappedCircVector(const string &path, size_t capacity = 1024,
+                   size_t sync_every = 0) {
+    if (capacity == 0) {
+      throw out_of_range("invalid capacity. must exceed zero");
+    }
+
+    this->base = nullptr;
+    this->mapped_length = 0;
+    this->fd = open(path.c_str(), O_RDWR);
+    if (this->fd < 0 && errno != ENOENT) {
+      fail("open");
+    }
+    this->sync_every = sync_every;
+    this->unsynced = 0;
+
+    try {
+      struct stat info;
+      if (this->fd >= 0 && fstat(this->fd, &info) != 0) {
+        fail("fstat");
+      }
+
+      // A missing or empty file holds no ring yet.
+      if (this->fd < 0 || info.st_size == 0) {
+        if (this->fd >= 0) {
+          close(this->fd);
+          this->fd = -1;
+        }
+        create(path, capacity);
+      } else {
+        if (info.st_size < static_cast<off_t>(sizeof(Header))) {
+          throw runtime_error("not a CircVector file: " + path);
+        }
+        map(info.st_size);
+        Header *head = header();
+        if (head->magic != file_magic || head->elem_size != sizeof(T) ||
+            head->live > 1) {
+          throw runtime_error("not a CircVector file of this type: " + path);
+        }
+
+        const State &live = head->states[head->live];
+        if (!valid(live)) {
+          throw runtime_error("corrupt CircVector file: " + path);
+        }
+        this->capacity = live.capacity;
+        this->front_idx = live.front_idx;
+        this->vec_size = live.size;
+      }
+    } catch (...) {
+      if (this->base != nullptr) {
+        munmap(this->base, this->mapped_length);
+      }
+      if (this->fd >= 0) {
+        close(this->fd);
+      }
+      throw;
+    }
+
+    this->data = reinterpret_cast<T *>(this->base + header()->data_offset);
+  }
+
+  MappedCircVector(const MappedCircVector &) = delete;
+  MappedCircVector &operator=(const MappedCircVector &) = delete;
+
+  /**
+   * Destructor. Unmaps and closes the file, syncing it first if `sync_every`
+   * was given. The ring stays in the file.
+   */
+  ~MappedCircVector() {
+    if (this->sync_every != 0 && this->unsynced != 0) {
+      msync(this->base, this->mapped_length, MS_SYNC);
+    }
+    munmap(this->base, this->mapped_length);
+    close(this->fd);
+  }
+
+  /**
+   * Returns whether the `MappedCircVector` is empty (i.e. whether its size
+   * is 0).
+   */
+  bool empty() const {
+    return this->vec_size == 0;
+  }
+
+  /**
+   * Returns the number of elements in the `MappedCircVector`.
+   */
+  size_t size() const {
+    return this->vec_size;
+  }
+
+  /**
+   * Returns the number of slots in the file.
+   */
+  size_t get_capacity() const {
+    return this->capacity;
+  }
+
+  /**
+   * Adds the given `T` to the back of the `MappedCircVector`.
+   */
+  void push_back(const T &elem) {
+    if (this->vec_size == this->capacity) {
+      grow();
+    }
+    this->data[wrap(this->front_idx, this->vec_size)] = elem;
+    this->vec_size++;
+    publish();
+  }
+
+  /**
+   * Adds the given `T` to the front of the `MappedCircVector`.
+   */
+  void push_front(const T &elem) {
+    if (this->vec_size == this->capacity) {
+      grow();
+    }
+    size_t idx =
+        this->front_idx == 0 ? this->capacity - 1 : this->front_idx - 1;
+    this->data[idx] = elem;
+    this->front_idx = idx;
+    this->vec_size++;
+    publish();
+  }
+
+  /**
+   * Removes the element at the front of the `MappedCircVector` and returns
+   * it.
+   *
+   * If the `MappedCircVector` is empty, throws a `runtime_error`.
+   */
+  T pop_front() {
+    if (this->vec_size == 0) {
+      throw runtime_error("operation can not be performed on empty vector");
+    }
+    T elem = this->data[this->front_idx];
+    this->front_idx = wrap(this->front_idx, 1);
+    this->vec_size--;
+    publish();
+    return elem;
+  }
+
+  /**
+   * Removes the element at the back of the `MappedCircVector` and returns it.
+   *
+   * If the `MappedCircVector` is empty, throws a `runtime_error`.
+   */
+  T pop_back() {
+    if (this->vec_size == 0) {
+      throw runtime_error("operation can not be performed on empty vector");
+    }
+    T elem = this->data[wrap(this->front_idx, this->vec_size - 1)];
+    this->vec_size--;
+    publish();
+    return elem;
+  }
+
+  /**
+   * Removes all elements from the `MappedCircVector`. Keeps the file size.
+   */
+  void clear() {
+    this->front_idx = 0;
+    this->vec_size = 0;
+    publish();
+  }
+
+  /**
+   * Returns the element at the given index in the `MappedCircVector`.
+   * Writes through the reference reach the file but are not ordered with
+   * the header.
+   *
+   * If the index is invalid, throws `out_of_range`.
+   */
+  T &at(size_t index) const {
+    if (index >= this->vec_size) {
+      throw out_of_range("index is out of range");
+    }
+    return this->data[wrap(this->front_idx, index)];
+  }
+
+  /**
+   * Searches the `MappedCircVector` for the first matching element, and
+   * returns its index. If no match is found, returns "-1". Scans the two
+   * runs of the ring directly, like `CircVector::find`.
+   */
+  size_t find(const T &target) const {
+    size_t head = min(this->vec_size, this->capacity - this->front_idx);
+    size_t idx = scan_find(this->data + this->front_idx, head, target);
+    if (idx != head) {
+      return idx;
+    }
+    size_t tail = this->vec_size - head;
+    idx = scan_find(this->data, tail, target);
+    if (idx != tail) {
+      return head + idx;
+    }
+    return -1;
+  }
+
+  /**
+   * Returns an iterator to the front element.
+   */
+  iterator begin() const {
+    return iterator(this, 0);
+  }
+
+  /**
+   * Returns an iterator past the back element.
+   */
+  iterator end() const {
+    return iterator(this, this->vec_size);
+  }
+
+  /**
+   * Flushes the ring to disk: first the slots, then the header, so that the
+   * header on disk never refers to slots that are not. Blocks until the
+   * writes are done.
+   */
+  void sync() {
+    size_t page = sysconf(_SC_PAGESIZE);
+    size_t data_start = header()->data_offset / page * page;
+    if (data_start != 0 &&
+        msync(this->base + data_start, this->mapped_length - data_start,
+              MS_SYNC) != 0) {
+      fail("msync");
+    }
+    if (msync(this->base, data_start == 0 ? this->mapped_length : data_start,
+              MS_SYNC) != 0) {
+      fail("msync");
+    }
+    this->unsynced = 0;
+  }
+
+  /**
+   * Converts the `MappedCircVector` to a string. Formatted like
+   * `[0, 1, 2, 3, 4]`.
+   */
+  string to_string() const {
+    stringstream oss;
+    oss << '[';
+    for (size_t i = 0; i < this->vec_size; i++) {
+      if (i != 0) {
+        oss << ", ";
+      }
+      oss << this->at(i);
+    }
+    oss << ']';
+    return oss.str();
+  }
+};
@@ -0,0 +1,208 @@
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "mappedcircvector.h"
+
+using namespace std;
+using namespace testing;
+
+// A fresh file name under the test temp directory, removed on destruction.
+class TempPath {
+ public:
+  string path;
+
+  TempPath(const string &name) {
+    this->path = TempDir() + name + "." + std::to_string(getpid());
+    remove(this->path.c_str());
+  }
+
+  ~TempPath() {
+    remove(this->path.c_str());
+  }
+};
+
+TEST(MappedCircVectorCore, push_pop) {
+  TempPath file("push_pop.ring");
+  MappedCircVector<int> ring(file.path, 4);
+
+  ring.push_back(1);
+  ring.push_back(2);
+  ring.push_front(0);
+  EXPECT_THAT(ring.to_string(), StrEq("[0, 1, 2]"));
+  EXPECT_THAT(ring.pop_back(), Eq(2));
+  EXPECT_THAT(ring.pop_front(), Eq(0));
+  EXPECT_THAT(ring.at(0), Eq(1));
+  EXPECT_THROW(ring.at(1), out_of_range);
+}
+
+TEST(MappedCircVectorCore, reopen) {
+  TempPath file("reopen.ring");
+  {
+    MappedCircVector<double, PowerOfTwoCapacity> ring(file.path, 3, 1);
+    for (int i = 0; i < 6; i++) {
+      ring.push_back(i + 0.5);
+    }
+    ring.pop_front();
+  }
+
+  MappedCircVector<double, PowerOfTwoCapacity> ring(file.path, 100);
+  EXPECT_THAT(ring.get_capacity(), Eq(8));
+  EXPECT_THAT(ring.to_string(), StrEq("[1.5, 2.5, 3.5, 4.5, 5.5]"));
+  ring.sync();
+}
+
+TEST(MappedCircVectorCore, grows_wrapped) {
+  TempPath file("grow.ring");
+  {
+    MappedCircVector<int> ring(file.path, 5);
+    for (int i = 0; i < 5; i++) {
+      ring.push_back(i);
+    }
+    ring.pop_front();
+    ring.pop_front();
+    ring.push_back(5);
+    ring.push_back(6);  // wraps: [2, 3, 4 | 5, 6]
+    ring.push_back(7);  // grows, short run moves
+    ring.push_front(1);
+    EXPECT_THAT(ring.get_capacity(), Eq(10));
+  }
+
+  MappedCircVector<int> ring(file.path);
+  EXPECT_THAT(ring.to_string(), StrEq("[1, 2, 3, 4, 5, 6, 7]"));
+}
+
+TEST(MappedCircVectorCore, find_and_iterate) {
+  TempPath file("find.ring");
+  MappedCircVector<int> ring(file.path, 4);
+  for (int i = 0; i < 4; i++) {
+    ring.push_back(i);
+  }
+  ring.pop_front();
+  ring.push_back(4);  // wrapped: [1, 2, 3 | 4]
+
+  EXPECT_THAT(ring.find(3), Eq(2));
+  EXPECT_THAT(ring.find(4), Eq(3));
+  EXPECT_THAT(ring.find(0), Eq(static_cast<size_t>(-1)));
+  EXPECT_THAT(vector<int>(ring.begin(), ring.end()), ElementsAre(1, 2, 3, 4));
+  EXPECT_THAT(ring.end() - ring.begin(), Eq(4));
+  EXPECT_THAT(*max_element(ring.begin(), ring.end()), Eq(4));
+}
+
+// The file only appears once it holds a header, and an empty file left
+// at the path (e.g. by `touch`) is initialized rather than rejected.
+TEST(MappedCircVectorCore, creates_atomically) {
+  TempPath file("create.ring");
+  string temp = file.path + ".tmp." + std::to_string(getpid());
+  {
+    MappedCircVector<int> ring(file.path, 8);
+    EXPECT_THAT(access(temp.c_str(), F_OK), Eq(-1));
+  }
+  MappedCircVector<int> reopened(file.path);
+  EXPECT_THAT(reopened.get_capacity(), Eq(8));
+
+  TempPath empty("empty.ring");
+  close(open(empty.path.c_str(), O_RDWR | O_CREAT, 0644));
+  MappedCircVector<int> ring(empty.path, 8);
+  ring.push_back(1);
+  EXPECT_THAT(ring.to_string(), StrEq("[1]"));
+}
+
+TEST(MappedCircVectorCore, wrong_type) {
+  TempPath file("wrong_type.ring");
+  {
+    MappedCircVector<int> ring(file.path);
+    ring.push_back(1);
+  }
+  EXPECT_THROW(MappedCircVector<double>(file.path), runtime_error);
+}
+
+// Overwrites field `field` (0 capacity, 1 front index, 2 size) of the live
+// state in the header of the ring file at `path`. The header is four
+// `uint64_t`s (magic, element size, data offset, live index) followed by
+// two states of three `uint64_t`s each.
+void corrupt_state(const string &path, int field, uint64_t value) {
+  int fd = open(path.c_str(), O_RDWR);
+  ASSERT_THAT(fd, Ge(0));
+  uint64_t live = 0;
+  ASSERT_THAT(pread(fd, &live, sizeof(live), 24), Eq(sizeof(live)));
+  off_t offset = 32 + live * 24 + field * 8;
+  ASSERT_THAT(pwrite(fd, &value, sizeof(value), offset), Eq(sizeof(value)));
+  close(fd);
+}
+
+TEST(MappedCircVectorCore, rejects_corrupt_header) {
+  TempPath file("corrupt.ring");
+  auto fresh = [&file] {
+    remove(file.path.c_str());
+    MappedCircVector<int> ring(file.path, 10);
+    ring.push_back(1);
+    ring.push_back(2);
+  };
+
+  fresh();
+  corrupt_state(file.path, 0, 0);
+  EXPECT_THROW(MappedCircVector<int>(file.path), runtime_error);
+
+  fresh();
+  corrupt_state(file.path, 0, 1 << 20);  // past the end of the file
+  EXPECT_THROW(MappedCircVector<int>(file.path), runtime_error);
+
+  fresh();
+  corrupt_state(file.path, 1, 10);
+  EXPECT_THROW(MappedCircVector<int>(file.path), runtime_error);
+
+  fresh();
+  corrupt_state(file.path, 2, 11);
+  EXPECT_THROW(MappedCircVector<int>(file.path), runtime_error);
+
+  fresh();
+  MappedCircVector<int> intact(file.path);
+  EXPECT_THAT(intact.to_string(), StrEq("[1, 2]"));
+}
+
+// A ring written with one capacity policy wraps indices its own way; a
+// policy that could not have produced its capacity must not reopen it.
+TEST(MappedCircVectorCore, rejects_other_capacity_policy) {
+  TempPath file("policy.ring");
+  {
+    MappedCircVector<int, ExactCapacity> ring(file.path, 10);
+    ring.push_back(1);
+  }
+  EXPECT_THROW((MappedCircVector<int, PowerOfTwoCapacity>(file.path)),
+               runtime_error);
+  MappedCircVector<int, ExactCapacity> ring(file.path);
+  EXPECT_THAT(ring.to_string(), StrEq("[1]"));
+}
+
+// A process that dies without unmapping still leaves every completed push
+// in the file.
+TEST(MappedCircVectorCore, survives_crash) {
+  TempPath file("crash.ring");
+  pid_t child = fork();
+  if (child == 0) {
+    MappedCircVector<long> ring(file.path, 16);
+    for (long i = 0; i < 1000; i++) {
+      ring.push_back(i);
+    }
+    ring.pop_front();
+    _exit(0);  // no destructor, no msync
+  }
+  int status = 0;
+  waitpid(child, &status, 0);
+  ASSERT_THAT(WIFEXITED(status), Eq(true));
+
+  MappedCircVector<long> ring(file.path);
+  EXPECT_THAT(ring.size(), Eq(999));
+  EXPECT_THAT(ring.at(0), Eq(1));
+  EXPECT_THAT(ring.at(998), Eq(999));
+}
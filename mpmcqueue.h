@@ -0,0 +1,263 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+
+#include "circvector.h"
+#include "concurrency.h"
+
+using namespace std;
+
+/**
+ * Bounded multi-producer/multi-consumer queue. Keeps the ring storage of
+ * `CircVector` (a fixed block of slots wrapped by a capacity policy, with
+ * elements constructed on push and destroyed on pop), and adds a sequence
+ * number to every slot so that no operation takes a global lock.
+ *
+ * A slot at position `pos` is free for the producer that claims `pos` when
+ * its sequence equals `pos`, and holds an element for the consumer that
+ * claims `pos` once its sequence equals `pos + 1`. Producers and consumers
+ * claim positions with a CAS on `enqueue_pos`/`dequeue_pos`, so threads
+ * only contend on those two counters, never on each other's slots.
+ *
+ * The blocking `push`/`pop` back off (spin, then yield) and finally park on
+ * the slot's sequence number until the other side changes it.
+ */
+template <typename T, typename CapacityPolicy = PowerOfTwoCapacity>
+class MPMCQueue {
+ private:
+  struct Slot {
+    atomic<size_t> sequence;
+    alignas(T) unsigned char storage[sizeof(T)];
+
+    T *elem() {
+      return reinterpret_cast<T *>(this->storage);
+    }
+  };
+
+  Slot *slots;
+  size_t capacity;
+
+  alignas(cache_line_size) atomic<size_t> enqueue_pos;
+  alignas(cache_line_size) atomic<size_t> dequeue_pos;
+
+  // Parked producers (waiting for room) and consumers (waiting for data).
+  // The other side only issues a wake-up when these are non-zero.
+  alignas(cache_line_size) atomic<uint32_t> push_waiters;
+  atomic<uint32_t> pop_waiters;
+
+  Slot &slot(size_t pos) const {
+    return this->slots[CapacityPolicy::wrap(pos, this->capacity)];
+  }
+
+  // Publishes `sequence` for `target` and wakes threads parked on it.
+  // The fence orders the store before the waiter check, pairing with the
+  // fence in `park()`, so a thread cannot park on a stale value unseen.
+  static void publish(Slot &target, size_t sequence,
+                      atomic<uint32_t> &waiters) {
+    target.sequence.store(sequence, memory_order_release);
+    atomic_thread_fence(memory_order_seq_cst);
+    if (waiters.load(memory_order_relaxed) != 0) {
+      target.sequence.notify_all();
+    }
+  }
+
+  // Blocks until `target`'s sequence differs from `seen`.
+  static void park(Slot &target, size_t seen, atomic<uint32_t> &waiters) {
+    waiters.fetch_add(1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    target.sequence.wait(seen, memory_order_acquire);
+    waiters.fetch_sub(1, memory_order_relaxed);
+  }
+
+  // Claims the next position of `counter` whose slot sequence is `pos +
+  // lag`, and returns that slot, or nullptr if the slot at the current
+  // position is a lap behind (the queue is full for producers, lag 0, or
+  // empty for consumers, lag 1). The caller then owns the slot until it
+  // publishes the next sequence.
+  Slot *claim(atomic<size_t> &counter, size_t lag, size_t &pos) {
+    pos = counter.load(memory_order_relaxed);
+    while (true) {
+      Slot *target = &slot(pos);
+      size_t seq = target->sequence.load(memory_order_acquire);
+      intptr_t diff = static_cast<intptr_t>(seq - (pos + lag));
+      if (diff == 0) {
+        if (counter.compare_exchange_weak(pos, pos + 1,
+                                          memory_order_relaxed)) {
+          return target;
+        }
+      } else if (diff < 0) {
+        return nullptr;
+      } else {
+        // Another thread claimed `pos` first; catch up.
+        pos = counter.load(memory_order_relaxed);
+      }
+    }
+  }
+
+  // Parks until the slot at the current position of `counter` changes, if
+  // it is still a lap behind. Returns immediately if it already moved on.
+  void wait_for(atomic<size_t> &counter, size_t lag,
+                atomic<uint32_t> &waiters) {
+    size_t pos = counter.load(memory_order_relaxed);
+    Slot &target = slot(pos);
+    size_t seq = target.sequence.load(memory_order_acquire);
+    if (static_cast<intptr_t>(seq - (pos + lag)) < 0) {
+      park(target, seq, waiters);
+    }
+  }
+
+ public:
+  /**
+   * Creates an empty queue with the given capacity, rounded up by the
+   * capacity policy and to at least 2. Capacity must exceed 0.
+   */
+  MPMCQueue(size_t capacity) {
+    if (capacity == 0) {
+      throw out_of_range("invalid capacity. must exceed zero");
+    }
+
+    // With a single slot, "free for lap n + 1" and "full from lap n" would
+    // be the same sequence number.
+    this->capacity = CapacityPolicy::round(max<size_t>(capacity, 2));
+    this->slots = allocator<Slot>().allocate(this->capacity);
+    for (size_t i = 0; i < this->capacity; i++) {
+      construct_at(&this->slots[i].sequence, i);
+    }
+    this->enqueue_pos.store(0, memory_order_relaxed);
+    this->dequeue_pos.store(0, memory_order_relaxed);
+    this->push_waiters.store(0, memory_order_relaxed);
+    this->pop_waiters.store(0, memory_order_relaxed);
+  }
+
+  MPMCQueue(const MPMCQueue &) = delete;
+  MPMCQueue &operator=(const MPMCQueue &) = delete;
+
+  /**
+   * Destructor. Destroys any elements still queued. No other thread may be
+   * using the queue.
+   */
+  ~MPMCQueue() {
+    size_t pos = this->dequeue_pos.load(memory_order_relaxed);
+    size_t end = this->enqueue_pos.load(memory_order_relaxed);
+    for (; pos != end; pos++) {
+      destroy_at(slot(pos).elem());
+    }
+    for (size_t i = 0; i < this->capacity; i++) {
+      destroy_at(&this->slots[i].sequence);
+    }
+    allocator<Slot>().deallocate(this->slots, this->capacity);
+  }
+
+  /**
+   * Constructs a `T` from `args` at the back of the queue. Returns false
+   * (without constructing anything) if the queue is full.
+   */
+  template <typename... Args>
+  bool try_emplace(Args &&...args) {
+    size_t pos;
+    Slot *target = claim(this->enqueue_pos, 0, pos);
+    if (target == nullptr) {
+      return false;
+    }
+
+    construct_at(target->elem(), forward<Args>(args)...);
+    publish(*target, pos + 1, this->pop_waiters);
+    return true;
+  }
+
+  /**
+   * Adds the given `T` to the back of the queue. Returns false if the queue
+   * is full.
+   */
+  bool try_push(const T &elem) {
+    return try_emplace(elem);
+  }
+
+  bool try_push(T &&elem) {
+    return try_emplace(move(elem));
+  }
+
+  /**
+   * Moves the element at the front of the queue into `out`. Returns false
+   * (leaving `out` untouched) if the queue is empty.
+   */
+  bool try_pop(T &out) {
+    size_t pos;
+    Slot *target = claim(this->dequeue_pos, 1, pos);
+    if (target == nullptr) {
+      return false;
+    }
+
+    out = move(*target->elem());
+    destroy_at(target->elem());
+    publish(*target, pos + this->capacity, this->push_waiters);
+    return true;
+  }
+
+  /**
+   * Adds the given `T` to the back of the queue, waiting for room if it is
+   * full: spins and yields first, then parks until a consumer frees a slot.
+   */
+  void push(T elem) {
+    Backoff backoff;
+    while (!try_push(move(elem))) {
+      if (!backoff.spin()) {
+        wait_for(this->enqueue_pos, 0, this->push_waiters);
+        backoff.reset();
+      }
+    }
+  }
+
+  /**
+   * Removes and returns the element at the front of the queue, waiting for
+   * one if it is empty: spins and yields first, then parks until a producer
+   * fills a slot.
+   */
+  T pop() {
+    Backoff backoff;
+    while (true) {
+      size_t pos;
+      Slot *target = claim(this->dequeue_pos, 1, pos);
+      if (target != nullptr) {
+        T out = move(*target->elem());
+        destroy_at(target->elem());
+        publish(*target, pos + this->capacity, this->push_waiters);
+        return out;
+      }
+
+      if (!backoff.spin()) {
+        wait_for(this->dequeue_pos, 1, this->pop_waiters);
+        backoff.reset();
+      }
+    }
+  }
+
+  /**
+   * Returns the number of queued elements. Only a snapshot while other
+   * threads are running.
+   */
+  size_t size() const {
+    size_t popped = this->dequeue_pos.load(memory_order_acquire);
+    size_t pushed = this->enqueue_pos.load(memory_order_acquire);
+    return pushed > popped ? pushed - popped : 0;
+  }
+
+  /**
+   * Returns whether the queue is empty. Only a snapshot while other threads
+   * are running.
+   */
+  bool empty() const {
+    return this->size() == 0;
+  }
+
+  /**
+   * Returns the fixed capacity of the queue.
+   */
+  size_t get_capacity() const {
+    return this->capacity;
+  }
+};
@@ -0,0 +1,125 @@
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "mpmcqueue.h"
+
+using namespace std;
+using namespace testing;
+
+TEST(MPMCQueueCore, push_pop) {
+  MPMCQueue<int> queue(4);
+  int out = 0;
+
+  EXPECT_THAT(queue.try_push(1), Eq(true));
+  EXPECT_THAT(queue.try_push(2), Eq(true));
+  EXPECT_THAT(queue.size(), Eq(2));
+  EXPECT_THAT(queue.try_pop(out), Eq(true));
+  EXPECT_THAT(out, Eq(1));
+  EXPECT_THAT(queue.pop(), Eq(2));
+}
+
+TEST(MPMCQueueCore, full_and_empty) {
+  MPMCQueue<int> queue(3);  // rounded up to 4
+  int out = 0;
+
+  EXPECT_THAT(queue.get_capacity(), Eq(4));
+  EXPECT_THAT(queue.try_pop(out), Eq(false));
+  for (int i = 0; i < 4; i++) {
+    EXPECT_THAT(queue.try_push(i), Eq(true));
+  }
+  EXPECT_THAT(queue.try_push(4), Eq(false));
+
+  // Wrap around a few laps.
+  for (int i = 4; i < 20; i++) {
+    EXPECT_THAT(queue.try_pop(out), Eq(true));
+    EXPECT_THAT(out, Eq(i - 4));
+    EXPECT_THAT(queue.try_push(i), Eq(true));
+  }
+}
+
+TEST(MPMCQueueCore, destroys_remaining) {
+  auto elem = make_shared<int>(1);
+  {
+    MPMCQueue<shared_ptr<int>> queue(4);
+    queue.try_push(elem);
+    queue.try_push(elem);
+    EXPECT_THAT(elem.use_count(), Eq(3));
+  }
+  EXPECT_THAT(elem.use_count(), Eq(1));
+}
+
+TEST(MPMCQueueThreads, blocking_pop_parks) {
+  MPMCQueue<string> queue(2);
+
+  thread producer([&] {
+    this_thread::sleep_for(chrono::milliseconds(20));
+    queue.push("late");
+  });
+
+  EXPECT_THAT(queue.pop(), StrEq("late"));
+  producer.join();
+}
+
+TEST(MPMCQueueThreads, blocking_push_parks) {
+  MPMCQueue<int> queue(1);  // rounded up to 2
+  queue.push(1);
+  queue.push(2);
+
+  thread consumer([&] {
+    this_thread::sleep_for(chrono::milliseconds(20));
+    queue.pop();
+  });
+
+  queue.push(3);  // full until the consumer wakes up
+  consumer.join();
+  EXPECT_THAT(queue.pop(), Eq(2));
+  EXPECT_THAT(queue.pop(), Eq(3));
+}
+
+// Runs `threads` producers against `threads` consumers on a small queue,
+// checks that every element comes out exactly once, and reports throughput
+// for 1 to 32 threads per side.
+TEST(MPMCQueueThreads, contention_scaling) {
+  const size_t per_run = 1 << 16;
+
+  for (size_t threads = 1; threads <= 32; threads *= 2) {
+    MPMCQueue<size_t> queue(256);
+    size_t per_thread = per_run / threads;
+    vector<size_t> sums(threads);
+    vector<thread> workers;
+
+    auto start = chrono::steady_clock::now();
+    for (size_t t = 0; t < threads; t++) {
+      workers.emplace_back([&queue, per_thread, t] {
+        for (size_t i = 0; i < per_thread; i++) {
+          queue.push(t * per_thread + i);
+        }
+      });
+      workers.emplace_back([&queue, &sums, per_thread, t] {
+        size_t sum = 0;
+        for (size_t i = 0; i < per_thread; i++) {
+          sum += queue.pop();
+        }
+        sums[t] = sum;
+      });
+    }
+    for (thread &worker : workers) {
+      worker.join();
+    }
+    chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+
+    size_t total = per_thread * threads;
+    size_t sum = 0;
+    for (size_t partial : sums) {
+      sum += partial;
+    }
+    EXPECT_THAT(sum, Eq(total * (total - 1) / 2));
+    EXPECT_THAT(queue.empty(), Eq(true));
+    cout << "[ MPMCQueue ] " << threads << " x " << threads << " threads: "
+         << total / elapsed.count() / 1e6 << " M elements/s" << endl;
+  }
+}
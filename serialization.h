@@ -0,0 +1,136 @@
+#pragma once
+
+#include <bit>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+
+using namespace std;
+
+// Helpers shared by the containers' `serialize`/`deserialize` and
+// `format_to`.
+//
+// The binary format is little-endian throughout: a `uint64_t` element count,
+// then the elements as `Serializer<T>` writes them. Arithmetic types are
+// their little-endian bytes, other trivially copyable types their raw
+// bytes, and strings a `uint64_t` length followed by the characters.
+// Specialize `Serializer` to add more element types.
+
+/**
+ * Reverses the bytes of `value` unless the host is little-endian.
+ */
+template <typename T>
+T to_little_endian(T value) {
+  if constexpr (endian::native == endian::little || sizeof(T) == 1 ||
+                !is_arithmetic_v<T>) {
+    return value;
+  } else {
+    unsigned char bytes[sizeof(T)];
+    memcpy(bytes, &value, sizeof(T));
+    for (size_t i = 0; i < sizeof(T) / 2; i++) {
+      swap(bytes[i], bytes[sizeof(T) - 1 - i]);
+    }
+    memcpy(&value, bytes, sizeof(T));
+    return value;
+  }
+}
+
+inline void write_bytes(ostream &out, const void *bytes, size_t count) {
+  out.write(static_cast<const char *>(bytes), count);
+}
+
+inline void read_bytes(istream &in, void *bytes, size_t count) {
+  if (!in.read(static_cast<char *>(bytes), count)) {
+    throw runtime_error("unexpected end of serialized data");
+  }
+}
+
+template <typename T>
+struct Serializer;
+
+template <typename T>
+  requires is_trivially_copyable_v<T>
+struct Serializer<T> {
+  // Whole arrays may be copied as they are in memory.
+  static constexpr bool raw_bulk =
+      endian::native == endian::little || sizeof(T) == 1 || !is_arithmetic_v<T>;
+
+  static void write(ostream &out, const T &value) {
+    T little = to_little_endian(value);
+    write_bytes(out, &little, sizeof(T));
+  }
+
+  static T read(istream &in) {
+    T value;
+    read_bytes(in, &value, sizeof(T));
+    return to_little_endian(value);
+  }
+};
+
+template <typename CharT, typename Traits, typename Alloc>
+struct Serializer<basic_string<CharT, Traits, Alloc>> {
+  static constexpr bool raw_bulk = false;
+
+  static void write(ostream &out,
+                    const basic_string<CharT, Traits, Alloc> &value) {
+    Serializer<uint64_t>::write(out, value.size());
+    write_bytes(out, value.data(), value.size() * sizeof(CharT));
+  }
+
+  static basic_string<CharT, Traits, Alloc> read(istream &in) {
+    basic_string<CharT, Traits, Alloc> value(Serializer<uint64_t>::read(in),
+                                             CharT());
+    read_bytes(in, value.data(), value.size() * sizeof(CharT));
+    return value;
+  }
+};
+
+/**
+ * Copies `text` into `[first, last)`. Returns the end of the written text,
+ * or `{last, errc::value_too_large}` if it does not fit.
+ */
+inline to_chars_result format_text(char *first, char *last,
+                                   string_view text) {
+  if (static_cast<size_t>(last - first) < text.size()) {
+    return {last, errc::value_too_large};
+  }
+  memcpy(first, text.data(), text.size());
+  return {first + text.size(), errc()};
+}
+
+/**
+ * Writes `value` into `[first, last)` exactly as `ostream << value` would
+ * with default flags: integers in decimal, floating point as `%g` with
+ * precision 6, characters as themselves, `bool` as `0`/`1`. These and
+ * strings are formatted without allocating; any other type goes through a
+ * `stringstream`.
+ */
+template <typename T>
+to_chars_result format_elem(char *first, char *last, const T &value) {
+  if constexpr (is_same_v<T, char> || is_same_v<T, signed char> ||
+                is_same_v<T, unsigned char>) {
+    const char *bytes = reinterpret_cast<const char *>(&value);
+    return format_text(first, last, string_view(bytes, 1));
+  } else if constexpr (is_same_v<T, bool>) {
+    return format_text(first, last, value ? "1" : "0");
+  } else if constexpr (is_integral_v<T>) {
+    return to_chars(first, last, value);
+  } else if constexpr (is_floating_point_v<T>) {
+    return to_chars(first, last, value, chars_format::general, 6);
+  } else if constexpr (is_convertible_v<const T &, string_view>) {
+    return format_text(first, last, string_view(value));
+  } else {
+    stringstream oss;
+    oss << value;
+    return format_text(first, last, oss.str());
+  }
+}
@@ -0,0 +1,343 @@
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#define SIMDSCAN_X86 1
+#endif
+
+using namespace std;
+
+// Linear scans over a contiguous array for elements equal to a target.
+// Element types with a vector compare (integers of 1, 2, 4 or 8 bytes,
+// `float` and `double`) are scanned 16 bytes at a time with SSE2, or 32 at a
+// time with AVX2 when the running CPU supports it; every other type, and
+// every other architecture, takes the scalar loop. All variants use the
+// element type's own `==`, so floating point keeps `NaN != NaN` and
+// `-0.0 == 0.0`.
+//
+// `scan_find` and `scan_rfind` return `count` when nothing matches.
+//
+// `scan_remove` compacts the array in place instead, dropping the matches.
+// The vector versions test a block of lanes at once and copy it as a whole
+// when nothing in it matches, skip it when everything does, and fall back
+// to a branch-free store per lane for mixed blocks.
+
+template <typename T>
+inline constexpr bool simd_scannable =
+    is_same_v<T, float> || is_same_v<T, double> ||
+    (is_integral_v<T> &&
+     (sizeof(T) == 1 || sizeof(T) == 2 || sizeof(T) == 4 || sizeof(T) == 8));
+
+template <typename T>
+size_t scan_find_scalar(const T *data, size_t count, const T &target) {
+  for (size_t i = 0; i < count; i++) {
+    if (data[i] == target) {
+      return i;
+    }
+  }
+  return count;
+}
+
+template <typename T>
+size_t scan_rfind_scalar(const T *data, size_t count, const T &target) {
+  for (size_t i = count; i > 0; i--) {
+    if (data[i - 1] == target) {
+      return i - 1;
+    }
+  }
+  return count;
+}
+
+template <typename T>
+size_t scan_count_scalar(const T *data, size_t count, const T &target) {
+  size_t matches = 0;
+  for (size_t i = 0; i < count; i++) {
+    matches += data[i] == target;
+  }
+  return matches;
+}
+
+template <typename T>
+size_t scan_remove_scalar(T *data, size_t count, const T &target) {
+  size_t kept = 0;
+  for (size_t i = 0; i < count; i++) {
+    // Always store, only advance for survivors: no unpredictable branch.
+    // `kept <= i`, so this never overwrites an element not yet read.
+    T elem = data[i];
+    data[kept] = elem;
+    kept += !(elem == target);
+  }
+  return kept;
+}
+
+#ifdef SIMDSCAN_X86
+
+// One bit per byte of the 16 bytes at `data`, set for the bytes of lanes
+// equal to `target`.
+template <typename T>
+inline unsigned sse2_eq_mask(const T *data, T target) {
+  if constexpr (is_same_v<T, float>) {
+    __m128 eq = _mm_cmpeq_ps(_mm_loadu_ps(data), _mm_set1_ps(target));
+    return _mm_movemask_epi8(_mm_castps_si128(eq));
+  } else if constexpr (is_same_v<T, double>) {
+    __m128d eq = _mm_cmpeq_pd(_mm_loadu_pd(data), _mm_set1_pd(target));
+    return _mm_movemask_epi8(_mm_castpd_si128(eq));
+  } else {
+    __m128i lanes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data));
+    __m128i eq;
+    if constexpr (sizeof(T) == 1) {
+      eq = _mm_cmpeq_epi8(lanes, _mm_set1_epi8(static_cast<char>(target)));
+    } else if constexpr (sizeof(T) == 2) {
+      eq = _mm_cmpeq_epi16(lanes, _mm_set1_epi16(static_cast<short>(target)));
+    } else if constexpr (sizeof(T) == 4) {
+      eq = _mm_cmpeq_epi32(lanes, _mm_set1_epi32(static_cast<int>(target)));
+    } else {
+      // SSE2 has no 64-bit compare: both 32-bit halves must match.
+      eq = _mm_cmpeq_epi32(lanes,
+                           _mm_set1_epi64x(static_cast<long long>(target)));
+      eq = _mm_and_si128(eq, _mm_shuffle_epi32(eq, _MM_SHUFFLE(2, 3, 0, 1)));
+    }
+    return _mm_movemask_epi8(eq);
+  }
+}
+
+// Same as `sse2_eq_mask`, over 32 bytes.
+template <typename T>
+__attribute__((target("avx2"))) inline unsigned avx2_eq_mask(const T *data,
+                                                              T target) {
+  if constexpr (is_same_v<T, float>) {
+    __m256 eq = _mm256_cmp_ps(_mm256_loadu_ps(data), _mm256_set1_ps(target),
+                              _CMP_EQ_OQ);
+    return _mm256_movemask_epi8(_mm256_castps_si256(eq));
+  } else if constexpr (is_same_v<T, double>) {
+    __m256d eq = _mm256_cmp_pd(_mm256_loadu_pd(data), _mm256_set1_pd(target),
+                               _CMP_EQ_OQ);
+    return _mm256_movemask_epi8(_mm256_castpd_si256(eq));
+  } else {
+    __m256i lanes =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data));
+    __m256i eq;
+    if constexpr (sizeof(T) == 1) {
+      eq = _mm256_cmpeq_epi8(lanes,
+                             _mm256_set1_epi8(static_cast<char>(target)));
+    } else if constexpr (sizeof(T) == 2) {
+      eq = _mm256_cmpeq_epi16(lanes,
+                              _mm256_set1_epi16(static_cast<short>(target)));
+    } else if constexpr (sizeof(T) == 4) {
+      eq = _mm256_cmpeq_epi32(lanes,
+                              _mm256_set1_epi32(static_cast<int>(target)));
+    } else {
+      eq = _mm256_cmpeq_epi64(
+          lanes, _mm256_set1_epi64x(static_cast<long long>(target)));
+    }
+    return _mm256_movemask_epi8(eq);
+  }
+}
+
+template <typename T>
+size_t scan_find_sse2(const T *data, size_t count, T target) {
+  constexpr size_t lanes = 16 / sizeof(T);
+  size_t i = 0;
+  for (; i + lanes <= count; i += lanes) {
+    unsigned mask = sse2_eq_mask(data + i, target);
+    if (mask != 0) {
+      return i + countr_zero(mask) / sizeof(T);
+    }
+  }
+  size_t rest = scan_find_scalar(data + i, count - i, target);
+  return rest == count - i ? count : i + rest;
+}
+
+template <typename T>
+__attribute__((target("avx2"))) size_t scan_find_avx2(const T *data,
+                                                      size_t count, T target) {
+  constexpr size_t lanes = 32 / sizeof(T);
+  size_t i = 0;
+  for (; i + lanes <= count; i += lanes) {
+    unsigned mask = avx2_eq_mask(data + i, target);
+    if (mask != 0) {
+      return i + countr_zero(mask) / sizeof(T);
+    }
+  }
+  size_t rest = scan_find_scalar(data + i, count - i, target);
+  return rest == count - i ? count : i + rest;
+}
+
+template <typename T>
+size_t scan_rfind_sse2(const T *data, size_t count, T target) {
+  constexpr size_t lanes = 16 / sizeof(T);
+  size_t end = count;
+  for (; end >= lanes; end -= lanes) {
+    unsigned mask = sse2_eq_mask(data + end - lanes, target);
+    if (mask != 0) {
+      return end - lanes + (31 - countl_zero(mask)) / sizeof(T);
+    }
+  }
+  size_t rest = scan_rfind_scalar(data, end, target);
+  return rest == end ? count : rest;
+}
+
+template <typename T>
+__attribute__((target("avx2"))) size_t scan_rfind_avx2(const T *data,
+                                                       size_t count,
+                                                       T target) {
+  constexpr size_t lanes = 32 / sizeof(T);
+  size_t end = count;
+  for (; end >= lanes; end -= lanes) {
+    unsigned mask = avx2_eq_mask(data + end - lanes, target);
+    if (mask != 0) {
+      return end - lanes + (31 - countl_zero(mask)) / sizeof(T);
+    }
+  }
+  size_t rest = scan_rfind_scalar(data, end, target);
+  return rest == end ? count : rest;
+}
+
+template <typename T>
+size_t scan_count_sse2(const T *data, size_t count, T target) {
+  constexpr size_t lanes = 16 / sizeof(T);
+  size_t matches = 0;
+  size_t i = 0;
+  for (; i + lanes <= count; i += lanes) {
+    matches += popcount(sse2_eq_mask(data + i, target));
+  }
+  return matches / sizeof(T) + scan_count_scalar(data + i, count - i, target);
+}
+
+template <typename T>
+__attribute__((target("avx2"))) size_t scan_count_avx2(const T *data,
+                                                       size_t count,
+                                                       T target) {
+  constexpr size_t lanes = 32 / sizeof(T);
+  size_t matches = 0;
+  size_t i = 0;
+  for (; i + lanes <= count; i += lanes) {
+    matches += popcount(avx2_eq_mask(data + i, target));
+  }
+  return matches / sizeof(T) + scan_count_scalar(data + i, count - i, target);
+}
+
+// Compacts one block of `lanes` elements at `data + i` down to `data + kept`
+// given its `sse2_eq_mask`/`avx2_eq_mask`, whose all-ones value is `full`.
+// Returns the number of survivors.
+template <typename T, size_t lanes>
+inline size_t compact_block(T *data, size_t i, size_t kept, unsigned mask,
+                            unsigned full) {
+  if (mask == 0) {
+    if (kept != i) {
+      memmove(data + kept, data + i, lanes * sizeof(T));
+    }
+    return lanes;
+  }
+  if (mask == full) {
+    return 0;
+  }
+  size_t start = kept;
+  for (size_t j = 0; j < lanes; j++) {
+    data[kept] = data[i + j];
+    kept += ((mask >> (j * sizeof(T))) & 1) == 0;
+  }
+  return kept - start;
+}
+
+template <typename T>
+size_t scan_remove_sse2(T *data, size_t count, T target) {
+  constexpr size_t lanes = 16 / sizeof(T);
+  size_t kept = 0;
+  size_t i = 0;
+  for (; i + lanes <= count; i += lanes) {
+    unsigned mask = sse2_eq_mask(data + i, target);
+    kept += compact_block<T, lanes>(data, i, kept, mask, 0xFFFF);
+  }
+  memmove(data + kept, data + i, (count - i) * sizeof(T));
+  return kept + scan_remove_scalar(data + kept, count - i, target);
+}
+
+template <typename T>
+__attribute__((target("avx2"))) size_t scan_remove_avx2(T *data,
+                                                        size_t count,
+                                                        T target) {
+  constexpr size_t lanes = 32 / sizeof(T);
+  size_t kept = 0;
+  size_t i = 0;
+  for (; i + lanes <= count; i += lanes) {
+    unsigned mask = avx2_eq_mask(data + i, target);
+    kept += compact_block<T, lanes>(data, i, kept, mask, 0xFFFFFFFF);
+  }
+  memmove(data + kept, data + i, (count - i) * sizeof(T));
+  return kept + scan_remove_scalar(data + kept, count - i, target);
+}
+
+// Checked once per process; SSE2 is part of the x86-64 baseline.
+inline bool cpu_has_avx2() {
+  static const bool supported = __builtin_cpu_supports("avx2");
+  return supported;
+}
+
+#endif  // SIMDSCAN_X86
+
+/**
+ * Returns the index of the first element of `data[0, count)` equal to
+ * `target`, or `count` if there is none.
+ */
+template <typename T>
+size_t scan_find(const T *data, size_t count, const T &target) {
+#ifdef SIMDSCAN_X86
+  if constexpr (simd_scannable<T>) {
+    return cpu_has_avx2() ? scan_find_avx2(data, count, target)
+                          : scan_find_sse2(data, count, target);
+  }
+#endif
+  return scan_find_scalar(data, count, target);
+}
+
+/**
+ * Returns the index of the last element of `data[0, count)` equal to
+ * `target`, or `count` if there is none.
+ */
+template <typename T>
+size_t scan_rfind(const T *data, size_t count, const T &target) {
+#ifdef SIMDSCAN_X86
+  if constexpr (simd_scannable<T>) {
+    return cpu_has_avx2() ? scan_rfind_avx2(data, count, target)
+                          : scan_rfind_sse2(data, count, target);
+  }
+#endif
+  return scan_rfind_scalar(data, count, target);
+}
+
+/**
+ * Returns how many elements of `data[0, count)` are equal to `target`.
+ */
+template <typename T>
+size_t scan_count(const T *data, size_t count, const T &target) {
+#ifdef SIMDSCAN_X86
+  if constexpr (simd_scannable<T>) {
+    return cpu_has_avx2() ? scan_count_avx2(data, count, target)
+                          : scan_count_sse2(data, count, target);
+  }
+#endif
+  return scan_count_scalar(data, count, target);
+}
+
+/**
+ * Removes every element of `data[0, count)` equal to `target`, moving the
+ * others down in order, and returns how many remain. Leftover slots past
+ * that keep unspecified values.
+ */
+template <typename T>
+size_t scan_remove(T *data, size_t count, const T &target) {
+#ifdef SIMDSCAN_X86
+  if constexpr (simd_scannable<T>) {
+    return cpu_has_avx2() ? scan_remove_avx2(data, count, target)
+                          : scan_remove_sse2(data, count, target);
+  }
+#endif
+  return scan_remove_scalar(data, count, target);
+}
@@ -0,0 +1,172 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+
+#include "circvector.h"
+
+using namespace std;
+
+/**
+ * Combine function for `SlidingWindow` keeping the smallest element.
+ */
+struct MinOf {
+  template <typename T>
+  const T &operator()(const T &a, const T &b) const {
+    return min(a, b);
+  }
+};
+
+/**
+ * Combine function for `SlidingWindow` keeping the largest element.
+ */
+struct MaxOf {
+  template <typename T>
+  const T &operator()(const T &a, const T &b) const {
+    return max(a, b);
+  }
+};
+
+/**
+ * FIFO window of `T` that keeps the aggregate of its elements under an
+ * associative `Combine`, like sum, min, max, gcd or string concatenation.
+ * `Combine` need not be commutative or have an identity: `query()` returns
+ * `combine(... combine(combine(oldest, next), next) ..., newest)`.
+ *
+ * Uses the two-stack technique: the window splits into an older part and a
+ * newer part. The newer part keeps one running aggregate, extended on every
+ * push. The older part keeps a stack of suffix aggregates, so popping the
+ * oldest element just pops its stack. When the older part runs out, the
+ * next pop rebuilds the stack over the whole window. Each element takes
+ * part in that rebuild once, so pushes and pops are amortized O(1) calls to
+ * `combine`, and `query()` at most one.
+ */
+template <typename T, typename Combine = plus<T>>
+class SlidingWindow {
+ private:
+  CircVector<T> values;  // The window, oldest first
+
+  // Suffix aggregates of the older part, the whole older part on top:
+  // `older[older.size() - 1 - i]` combines `values[i]` up to the end of the
+  // older part.
+  CircVector<T> older;
+
+  // Aggregate of the newer part, `values[older.size()...]`; empty if it
+  // holds no element.
+  optional<T> newer;
+
+  [[no_unique_address]] Combine combine;
+
+  // Moves every element into the older part.
+  void flip() {
+    this->older.clear();
+    for (size_t i = this->values.size(); i > 0; i--) {
+      const T &value = this->values.at(i - 1);
+      if (this->older.empty()) {
+        this->older.push_back(value);
+      } else {
+        this->older.push_back(
+            this->combine(value, this->older.at(this->older.size() - 1)));
+      }
+    }
+    this->newer.reset();
+  }
+
+ public:
+  /**
+   * Constructs an empty `SlidingWindow` with room for `capacity` elements
+   * before it reallocates.
+   */
+  explicit SlidingWindow(size_t capacity = 10, Combine combine = Combine())
+      : values(capacity), older(capacity), combine(move(combine)) {
+  }
+
+  /**
+   * Returns whether the window is empty.
+   */
+  bool empty() const {
+    return this->values.empty();
+  }
+
+  /**
+   * Returns the number of elements in the window.
+   */
+  size_t size() const {
+    return this->values.size();
+  }
+
+  /**
+   * Returns the element at the given index in the window, 0 being the
+   * oldest.
+   *
+   * If the index is invalid, throws `out_of_range`.
+   */
+  const T &at(size_t index) const {
+    return this->values.at(index);
+  }
+
+  /**
+   * Adds the given `T` as the newest element of the window. Amortized O(1).
+   */
+  void push_back(const T &elem) {
+    if (this->newer) {
+      this->newer = this->combine(*this->newer, elem);
+    } else {
+      this->newer = elem;
+    }
+    this->values.push_back(elem);
+  }
+
+  /**
+   * Removes the oldest element of the window and returns it. Amortized
+   * O(1).
+   *
+   * If the window is empty, throws a `runtime_error`.
+   */
+  T pop_front() {
+    if (this->values.empty()) {
+      throw runtime_error("operation can not be performed on empty window");
+    }
+    if (this->older.empty()) {
+      flip();
+    }
+    this->older.pop_back();
+    return this->values.pop_front();
+  }
+
+  /**
+   * Returns the aggregate of the whole window. O(1).
+   *
+   * If the window is empty, throws a `runtime_error`.
+   */
+  T query() const {
+    if (this->older.empty()) {
+      if (!this->newer) {
+        throw runtime_error("operation can not be performed on empty window");
+      }
+      return *this->newer;
+    }
+    const T &top = this->older.at(this->older.size() - 1);
+    return this->newer ? this->combine(top, *this->newer) : top;
+  }
+
+  /**
+   * Removes all elements from the window.
+   */
+  void clear() {
+    this->values.clear();
+    this->older.clear();
+    this->newer.reset();
+  }
+
+  /**
+   * Returns the elements of the window, oldest first.
+   */
+  const CircVector<T> &get_values() const {
+    return this->values;
+  }
+};
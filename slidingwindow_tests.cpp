@@ -0,0 +1,132 @@
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <numeric>
+#include <random>
+#include <string>
+
+#include "slidingwindow.h"
+
+using namespace std;
+using namespace testing;
+
+// Aggregate of `window` computed by looping over it, to check against.
+template <typename T, typename Combine>
+T brute_force(const SlidingWindow<T, Combine> &window, Combine combine) {
+  T result = window.at(0);
+  for (size_t i = 1; i < window.size(); i++) {
+    result = combine(result, window.at(i));
+  }
+  return result;
+}
+
+TEST(SlidingWindowCore, sum) {
+  SlidingWindow<int> window;
+
+  window.push_back(1);
+  window.push_back(2);
+  window.push_back(3);
+  EXPECT_THAT(window.query(), Eq(6));
+  EXPECT_THAT(window.pop_front(), Eq(1));
+  EXPECT_THAT(window.query(), Eq(5));
+  window.push_back(4);
+  EXPECT_THAT(window.query(), Eq(9));
+  EXPECT_THAT(window.size(), Eq(3));
+  EXPECT_THAT(window.get_values().to_string(), StrEq("[2, 3, 4]"));
+}
+
+TEST(SlidingWindowCore, empty_throws) {
+  SlidingWindow<int, MinOf> window;
+
+  EXPECT_THROW(window.query(), runtime_error);
+  EXPECT_THROW(window.pop_front(), runtime_error);
+  window.push_back(1);
+  window.pop_front();
+  EXPECT_THROW(window.query(), runtime_error);
+}
+
+TEST(SlidingWindowCore, clear) {
+  SlidingWindow<int, MaxOf> window;
+
+  window.push_back(5);
+  window.push_back(7);
+  window.pop_front();
+  window.clear();
+  EXPECT_THAT(window.empty(), Eq(true));
+  window.push_back(3);
+  EXPECT_THAT(window.query(), Eq(3));
+}
+
+TEST(SlidingWindowCore, fixed_width_min_max) {
+  SlidingWindow<int, MinOf> lows;
+  SlidingWindow<int, MaxOf> highs;
+  mt19937 rng(7);
+
+  for (int i = 0; i < 2000; i++) {
+    int sample = rng() % 1000;
+    lows.push_back(sample);
+    highs.push_back(sample);
+    if (lows.size() > 50) {
+      lows.pop_front();
+      highs.pop_front();
+    }
+    ASSERT_THAT(lows.query(), Eq(brute_force(lows, MinOf())));
+    ASSERT_THAT(highs.query(), Eq(brute_force(highs, MaxOf())));
+  }
+}
+
+TEST(SlidingWindowCore, gcd) {
+  auto combine = [](long a, long b) { return std::gcd(a, b); };
+  SlidingWindow<long, decltype(combine)> window(10, combine);
+
+  window.push_back(12);
+  window.push_back(18);
+  window.push_back(30);
+  EXPECT_THAT(window.query(), Eq(6));
+  window.pop_front();
+  window.push_back(45);
+  EXPECT_THAT(window.query(), Eq(3));
+  window.pop_front();
+  EXPECT_THAT(window.query(), Eq(15));
+}
+
+// Concatenation is associative but not commutative, so this checks that the
+// aggregate keeps the window's order across the two stacks.
+TEST(SlidingWindowCore, keeps_order) {
+  SlidingWindow<string> window;
+
+  window.push_back("a");
+  window.push_back("b");
+  window.push_back("c");
+  window.pop_front();
+  window.push_back("d");
+  window.push_back("e");
+  EXPECT_THAT(window.query(), StrEq("bcde"));
+  window.pop_front();
+  EXPECT_THAT(window.query(), StrEq("cde"));
+  window.pop_front();
+  window.pop_front();
+  window.push_back("f");
+  EXPECT_THAT(window.query(), StrEq("ef"));
+}
+
+TEST(SlidingWindowCore, amortized_constant) {
+  size_t calls = 0;
+  auto combine = [&calls](int a, int b) {
+    calls++;
+    return a + b;
+  };
+  SlidingWindow<int, decltype(combine)> window(10, combine);
+
+  const size_t ops = 100000;
+  for (size_t i = 0; i < ops; i++) {
+    window.push_back(1);
+    if (window.size() > 1000) {
+      window.pop_front();
+    }
+    window.query();
+  }
+  // One call per push, at most one per rebuilt element, one per query.
+  EXPECT_THAT(calls, Le(3 * ops));
+  EXPECT_THAT(window.query(), Eq(1000));
+}
@@ -0,0 +1,235 @@
+#pragma once
+
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include "circvector.h"
+#include "concurrency.h"
+
+using namespace std;
+
+/**
+ * Lock-free single-producer/single-consumer ring. Uses the same slot layout
+ * as `CircVector` (uninitialized storage, elements constructed on push and
+ * destroyed on pop, indices wrapped by a capacity policy), but the capacity
+ * is fixed at construction: a push onto a full ring fails instead of growing.
+ *
+ * Exactly one thread may call the `try_push*` functions and exactly one
+ * (other) thread the `try_pop*` functions. `head` and `tail` count pops and
+ * pushes since construction and each live on their own cache line; each side
+ * also keeps a cached copy of the opposite index and only re-reads the shared
+ * one when the cached value says the ring looks full (or empty).
+ */
+template <typename T, typename CapacityPolicy = PowerOfTwoCapacity>
+class SPSCRing {
+ private:
+  // Read-only after construction, shared by both sides.
+  alignas(cache_line_size) T *data;
+  size_t capacity;
+
+  // Consumer side: the next element to pop, and the last `tail` it saw.
+  alignas(cache_line_size) atomic<size_t> head;
+  size_t cached_tail;
+
+  // Producer side: the next slot to push into, and the last `head` it saw.
+  alignas(cache_line_size) atomic<size_t> tail;
+  size_t cached_head;
+
+  T *slot(size_t count) const {
+    return this->data + CapacityPolicy::wrap(count, this->capacity);
+  }
+
+  // Returns how many slots the producer may fill starting at `pushed`,
+  // re-reading the consumer's index only when the cache says the ring is
+  // out of room for `wanted` elements.
+  size_t free_slots(size_t pushed, size_t wanted) {
+    size_t room = this->capacity - (pushed - this->cached_head);
+    if (room < wanted) {
+      this->cached_head = this->head.load(memory_order_acquire);
+      room = this->capacity - (pushed - this->cached_head);
+    }
+    return room;
+  }
+
+  // Returns how many elements the consumer may take starting at `popped`,
+  // re-reading the producer's index only when the cache says there are
+  // fewer than `wanted`.
+  size_t ready_slots(size_t popped, size_t wanted) {
+    size_t ready = this->cached_tail - popped;
+    if (ready < wanted) {
+      this->cached_tail = this->tail.load(memory_order_acquire);
+      ready = this->cached_tail - popped;
+    }
+    return ready;
+  }
+
+ public:
+  /**
+   * Creates an empty ring with the given capacity, rounded up by the
+   * capacity policy. Capacity must exceed 0.
+   */
+  SPSCRing(size_t capacity) {
+    if (capacity == 0) {
+      throw out_of_range("invalid capacity. must exceed zero");
+    }
+
+    this->capacity = CapacityPolicy::round(capacity);
+    this->data = allocator<T>().allocate(this->capacity);
+    this->head.store(0, memory_order_relaxed);
+    this->tail.store(0, memory_order_relaxed);
+    this->cached_head = 0;
+    this->cached_tail = 0;
+  }
+
+  SPSCRing(const SPSCRing &) = delete;
+  SPSCRing &operator=(const SPSCRing &) = delete;
+
+  /**
+   * Destructor. Destroys any elements still queued. No other thread may be
+   * using the ring.
+   */
+  ~SPSCRing() {
+    size_t popped = this->head.load(memory_order_relaxed);
+    size_t pushed = this->tail.load(memory_order_relaxed);
+    for (; popped != pushed; popped++) {
+      destroy_at(slot(popped));
+    }
+    allocator<T>().deallocate(this->data, this->capacity);
+  }
+
+  /**
+   * Producer only. Constructs a `T` from `args` at the back of the ring.
+   * Returns false (without constructing anything) if the ring is full.
+   */
+  template <typename... Args>
+  bool try_emplace(Args &&...args) {
+    size_t pushed = this->tail.load(memory_order_relaxed);
+    if (free_slots(pushed, 1) == 0) {
+      return false;
+    }
+
+    construct_at(slot(pushed), forward<Args>(args)...);
+    this->tail.store(pushed + 1, memory_order_release);
+    return true;
+  }
+
+  /**
+   * Producer only. Adds the given `T` to the back of the ring. Returns false
+   * if the ring is full.
+   */
+  bool try_push(const T &elem) {
+    return try_emplace(elem);
+  }
+
+  bool try_push(T &&elem) {
+    return try_emplace(move(elem));
+  }
+
+  /**
+   * Producer only. Copies up to `count` elements from `src` to the back of
+   * the ring, publishing them all with a single index update. Returns how
+   * many were pushed, which is less than `count` if the ring filled up.
+   *
+   * If copying an element throws, pushes none of them.
+   */
+  size_t try_push_n(const T *src, size_t count) {
+    size_t pushed = this->tail.load(memory_order_relaxed);
+    count = min(count, free_slots(pushed, count));
+    if (count == 0) {
+      return 0;
+    }
+
+    size_t start = CapacityPolicy::wrap(pushed, this->capacity);
+    size_t head_run = min(count, this->capacity - start);
+    if constexpr (is_trivially_copyable_v<T>) {
+      memcpy(this->data + start, src, head_run * sizeof(T));
+      memcpy(this->data, src + head_run, (count - head_run) * sizeof(T));
+    } else {
+      uninitialized_copy_n(src, head_run, this->data + start);
+      try {
+        uninitialized_copy_n(src + head_run, count - head_run, this->data);
+      } catch (...) {
+        // Never published, so the consumer cannot see them: undo the run.
+        destroy_n(this->data + start, head_run);
+        throw;
+      }
+    }
+    this->tail.store(pushed + count, memory_order_release);
+    return count;
+  }
+
+  /**
+   * Consumer only. Moves the element at the front of the ring into `out`.
+   * Returns false (leaving `out` untouched) if the ring is empty.
+   */
+  bool try_pop(T &out) {
+    size_t popped = this->head.load(memory_order_relaxed);
+    if (ready_slots(popped, 1) == 0) {
+      return false;
+    }
+
+    T *elem = slot(popped);
+    out = move(*elem);
+    destroy_at(elem);
+    this->head.store(popped + 1, memory_order_release);
+    return true;
+  }
+
+  /**
+   * Consumer only. Moves up to `count` elements from the front of the ring
+   * into `out`, in order, freeing their slots with a single index update.
+   * Returns how many were popped.
+   */
+  size_t try_pop_n(T *out, size_t count) {
+    size_t popped = this->head.load(memory_order_relaxed);
+    count = min(count, ready_slots(popped, count));
+    if (count == 0) {
+      return 0;
+    }
+
+    size_t start = CapacityPolicy::wrap(popped, this->capacity);
+    size_t head_run = min(count, this->capacity - start);
+    if constexpr (is_trivially_copyable_v<T>) {
+      memcpy(out, this->data + start, head_run * sizeof(T));
+      memcpy(out + head_run, this->data, (count - head_run) * sizeof(T));
+    } else {
+      move(this->data + start, this->data + start + head_run, out);
+      move(this->data, this->data + count - head_run, out + head_run);
+      destroy_n(this->data + start, head_run);
+      destroy_n(this->data, count - head_run);
+    }
+    this->head.store(popped + count, memory_order_release);
+    return count;
+  }
+
+  /**
+   * Returns the number of queued elements. Only a snapshot when the other
+   * side is running concurrently.
+   */
+  size_t size() const {
+    // Read `head` first: `tail` can only have grown since, so the
+    // difference never underflows.
+    size_t popped = this->head.load(memory_order_acquire);
+    size_t pushed = this->tail.load(memory_order_acquire);
+    return pushed - popped;
+  }
+
+  /**
+   * Returns whether the ring is empty. Only a snapshot when the other side
+   * is running concurrently.
+   */
+  bool empty() const {
+    return this->size() == 0;
+  }
+
+  /**
+   * Returns the fixed capacity of the ring.
+   */
+  size_t get_capacity() const {
+    return this->capacity;
+  }
+};
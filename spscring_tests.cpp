@@ -0,0 +1,204 @@
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "spscring.h"
+
+using namespace std;
+using namespace testing;
+
+TEST(SPSCRingCore, push_pop) {
+  SPSCRing<int> ring(4);
+  int out = 0;
+
+  EXPECT_THAT(ring.try_push(1), Eq(true));
+  EXPECT_THAT(ring.try_push(2), Eq(true));
+  EXPECT_THAT(ring.size(), Eq(2));
+  EXPECT_THAT(ring.try_pop(out), Eq(true));
+  EXPECT_THAT(out, Eq(1));
+}
+
+TEST(SPSCRingCore, full_and_empty) {
+  SPSCRing<int> ring(3);  // rounded up to 4
+  int out = 0;
+
+  EXPECT_THAT(ring.get_capacity(), Eq(4));
+  EXPECT_THAT(ring.try_pop(out), Eq(false));
+  for (int i = 0; i < 4; i++) {
+    EXPECT_THAT(ring.try_push(i), Eq(true));
+  }
+  EXPECT_THAT(ring.try_push(4), Eq(false));
+  EXPECT_THAT(ring.size(), Eq(4));
+}
+
+TEST(SPSCRingCore, batched_wraparound) {
+  SPSCRing<string> ring(4);
+  vector<string> in = {"a", "b", "c", "d", "e"};
+  vector<string> out(5);
+
+  EXPECT_THAT(ring.try_push_n(in.data(), 3), Eq(3));
+  EXPECT_THAT(ring.try_pop_n(out.data(), 2), Eq(2));
+  EXPECT_THAT(ring.try_push_n(in.data() + 3, 2), Eq(2));  // wraps
+  EXPECT_THAT(ring.try_push_n(in.data(), 5), Eq(1));       // only one free
+  EXPECT_THAT(ring.try_pop_n(out.data(), 5), Eq(4));
+
+  EXPECT_THAT(out[0], StrEq("c"));
+  EXPECT_THAT(out[2], StrEq("e"));
+  EXPECT_THAT(out[3], StrEq("a"));
+  EXPECT_THAT(ring.empty(), Eq(true));
+}
+
+TEST(SPSCRingCore, destroys_remaining) {
+  auto elem = make_shared<int>(1);
+  {
+    SPSCRing<shared_ptr<int>> ring(4);
+    ring.try_push(elem);
+    ring.try_push(elem);
+    EXPECT_THAT(elem.use_count(), Eq(3));
+  }
+  EXPECT_THAT(elem.use_count(), Eq(1));
+}
+
+namespace {
+
+// Counts live instances; the copy constructor throws once `copies_left`
+// copies have been made.
+struct ThrowingCopy {
+  static int live;
+  static int copies_left;
+  int value;
+
+  ThrowingCopy(int value) : value(value) {
+    live++;
+  }
+  ThrowingCopy(const ThrowingCopy &other) : value(other.value) {
+    if (copies_left-- == 0) {
+      throw runtime_error("copy failed");
+    }
+    live++;
+  }
+  ThrowingCopy &operator=(const ThrowingCopy &other) = default;
+  ~ThrowingCopy() {
+    live--;
+  }
+};
+int ThrowingCopy::live = 0;
+int ThrowingCopy::copies_left = 0;
+
+}  // namespace
+
+TEST(SPSCRingCore, throwing_batch_pushes_nothing) {
+  ThrowingCopy::live = 0;
+  {
+    ThrowingCopy::copies_left = 6;
+    SPSCRing<ThrowingCopy> ring(4);
+    vector<ThrowingCopy> in = {1, 2, 3};
+    ThrowingCopy out(0);
+    ring.try_push_n(in.data(), 3);
+    for (int i = 0; i < 3; i++) {
+      ring.try_pop(out);
+    }
+    EXPECT_THAT(ThrowingCopy::live, Eq(4));
+
+    // Wraps after one element, then fails on the second run.
+    ThrowingCopy::copies_left = 2;
+    EXPECT_THROW(ring.try_push_n(in.data(), 3), runtime_error);
+    EXPECT_THAT(ThrowingCopy::live, Eq(4));
+    EXPECT_THAT(ring.empty(), Eq(true));
+
+    ThrowingCopy::copies_left = 3;
+    EXPECT_THAT(ring.try_push_n(in.data(), 3), Eq(3));
+    EXPECT_THAT(ring.try_pop(out), Eq(true));
+    EXPECT_THAT(out.value, Eq(1));
+  }
+  EXPECT_THAT(ThrowingCopy::live, Eq(0));
+}
+
+// Streams a counting sequence through the ring from one thread to another
+// and checks it arrives complete and in order. Also reports throughput.
+TEST(SPSCRingThreads, throughput) {
+  const size_t count = 1 << 20;
+  const size_t batch = 64;
+  SPSCRing<size_t> ring(1024);
+  bool in_order = true;
+
+  auto start = chrono::steady_clock::now();
+  thread consumer([&] {
+    vector<size_t> out(batch);
+    size_t expected = 0;
+    while (expected < count) {
+      size_t popped = ring.try_pop_n(out.data(), batch);
+      if (popped == 0) {
+        this_thread::yield();
+      }
+      for (size_t i = 0; i < popped; i++) {
+        in_order &= out[i] == expected++;
+      }
+    }
+  });
+
+  vector<size_t> in(batch);
+  for (size_t next = 0; next < count;) {
+    size_t wanted = min(batch, count - next);
+    for (size_t i = 0; i < wanted; i++) {
+      in[i] = next + i;
+    }
+    size_t pushed = ring.try_push_n(in.data(), wanted);
+    if (pushed == 0) {
+      this_thread::yield();
+    }
+    next += pushed;
+  }
+  consumer.join();
+  chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+
+  EXPECT_THAT(in_order, Eq(true));
+  EXPECT_THAT(ring.empty(), Eq(true));
+  cout << "[ SPSCRing ] " << count / elapsed.count() / 1e6
+       << " M elements/s (batches of " << batch << ")" << endl;
+}
+
+// Bounces a token between two rings and reports the median round trip.
+// Waiters yield rather than spin so the test also finishes on one core.
+TEST(SPSCRingThreads, latency) {
+  const int rounds = 10000;
+  SPSCRing<int> ping(16);
+  SPSCRing<int> pong(16);
+
+  thread echo([&] {
+    for (int i = 0; i < rounds; i++) {
+      int token;
+      while (!ping.try_pop(token)) {
+        this_thread::yield();
+      }
+      while (!pong.try_push(token)) {
+        this_thread::yield();
+      }
+    }
+  });
+
+  vector<chrono::nanoseconds> trips;
+  trips.reserve(rounds);
+  bool echoed = true;
+  for (int i = 0; i < rounds; i++) {
+    auto start = chrono::steady_clock::now();
+    ping.try_push(i);
+    int token;
+    while (!pong.try_pop(token)) {
+      this_thread::yield();
+    }
+    trips.push_back(chrono::steady_clock::now() - start);
+    echoed &= token == i;
+  }
+  echo.join();
+
+  EXPECT_THAT(echoed, Eq(true));
+  nth_element(trips.begin(), trips.begin() + rounds / 2, trips.end());
+  cout << "[ SPSCRing ] median round trip " << trips[rounds / 2].count()
+       << " ns" << endl;
+}
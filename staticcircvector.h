@@ -0,0 +1,378 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <span>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#include "simdscan.h"
+
+using namespace std;
+
+/**
+ * Ring buffer of at most `N` elements of `T`, stored inside the object. The
+ * capacity is a compile-time constant, so wrapping an index is a constant
+ * modulo (a mask when `N` is a power of two), and the ring never allocates:
+ * it can live on the stack or inside other structs.
+ *
+ * Everything but `to_string` is `constexpr`, so rings can be built and
+ * queried during constant evaluation. To allow that, the slots are a plain
+ * array and `T` must be default-constructible; free slots hold a
+ * value-initialized `T`.
+ *
+ * Pushing onto a full ring throws `length_error`.
+ */
+template <typename T, size_t N>
+class StaticCircVector {
+  static_assert(N > 0, "StaticCircVector needs at least one slot");
+  static_assert(is_default_constructible_v<T>,
+                "StaticCircVector slots must be default-constructible");
+
+ private:
+  T data[N] = {};
+  size_t vec_size = 0;   // size of array
+  size_t front_idx = 0;  // index of front of the array
+
+  // Maps `index + difference` onto the ring. Both operands are below `N`.
+  static constexpr size_t wrap(size_t index, size_t difference) {
+    return (index + difference) % N;
+  }
+
+  // Steps an index back by one slot.
+  static constexpr size_t wrap_back(size_t index) {
+    return index == 0 ? N - 1 : index - 1;
+  }
+
+  constexpr T &slot(size_t index) {
+    return this->data[wrap(this->front_idx, index)];
+  }
+
+  constexpr const T &slot(size_t index) const {
+    return this->data[wrap(this->front_idx, index)];
+  }
+
+  // Returns a slot to its free state, releasing whatever the element held.
+  static constexpr void release(T &elem) {
+    elem = T();
+  }
+
+  constexpr void check_not_full() const {
+    if (this->vec_size == N) {
+      throw length_error("StaticCircVector is full");
+    }
+  }
+
+  constexpr void check_not_empty() const {
+    if (this->vec_size == 0) {
+      throw runtime_error("operation can not be performed on empty vector");
+    }
+  }
+
+ public:
+  /**
+   * Constructs an empty `StaticCircVector`.
+   */
+  constexpr StaticCircVector() = default;
+
+  /**
+   * Returns whether the `StaticCircVector` is empty (i.e. whether its size
+   * is 0).
+   */
+  constexpr bool empty() const {
+    return this->vec_size == 0;
+  }
+
+  /**
+   * Returns whether the `StaticCircVector` holds `N` elements.
+   */
+  constexpr bool full() const {
+    return this->vec_size == N;
+  }
+
+  /**
+   * Returns the number of elements in the `StaticCircVector`.
+   */
+  constexpr size_t size() const {
+    return this->vec_size;
+  }
+
+  /**
+   * Returns `N`.
+   */
+  static constexpr size_t get_capacity() {
+    return N;
+  }
+
+  /**
+   * Constructs a `T` from `args` in the slot before the front of the
+   * `StaticCircVector`, and returns a reference to it.
+   *
+   * If the `StaticCircVector` is full, throws `length_error`.
+   */
+  template <typename... Args>
+  constexpr T &emplace_front(Args &&...args) {
+    check_not_full();
+    size_t idx = wrap_back(this->front_idx);
+    this->data[idx] = T(forward<Args>(args)...);
+    this->front_idx = idx;
+    this->vec_size++;
+    return this->data[idx];
+  }
+
+  /**
+   * Constructs a `T` from `args` in the slot after the back of the
+   * `StaticCircVector`, and returns a reference to it.
+   *
+   * If the `StaticCircVector` is full, throws `length_error`.
+   */
+  template <typename... Args>
+  constexpr T &emplace_back(Args &&...args) {
+    check_not_full();
+    T &elem = slot(this->vec_size);
+    elem = T(forward<Args>(args)...);
+    this->vec_size++;
+    return elem;
+  }
+
+  /**
+   * Adds the given `T` to the front of the `StaticCircVector`.
+   *
+   * If the `StaticCircVector` is full, throws `length_error`.
+   */
+  constexpr void push_front(const T &elem) {
+    emplace_front(elem);
+  }
+
+  constexpr void push_front(T &&elem) {
+    emplace_front(move(elem));
+  }
+
+  /**
+   * Adds the given `T` to the back of the `StaticCircVector`.
+   *
+   * If the `StaticCircVector` is full, throws `length_error`.
+   */
+  constexpr void push_back(const T &elem) {
+    emplace_back(elem);
+  }
+
+  constexpr void push_back(T &&elem) {
+    emplace_back(move(elem));
+  }
+
+  /**
+   * Removes the element at the front of the `StaticCircVector` and returns
+   * it by move.
+   *
+   * If the `StaticCircVector` is empty, throws a `runtime_error`.
+   */
+  constexpr T pop_front() {
+    check_not_empty();
+    T elem = move(this->data[this->front_idx]);
+    release(this->data[this->front_idx]);
+    this->front_idx = wrap(this->front_idx, 1);
+    this->vec_size--;
+    return elem;
+  }
+
+  /**
+   * Removes the element at the back of the `StaticCircVector` and returns it
+   * by move.
+   *
+   * If the `StaticCircVector` is empty, throws a `runtime_error`.
+   */
+  constexpr T pop_back() {
+    check_not_empty();
+    T &back = slot(this->vec_size - 1);
+    T elem = move(back);
+    release(back);
+    this->vec_size--;
+    return elem;
+  }
+
+  /**
+   * Removes all elements from the `StaticCircVector`.
+   */
+  constexpr void clear() {
+    for (size_t i = 0; i < this->vec_size; i++) {
+      release(slot(i));
+    }
+    this->front_idx = 0;
+    this->vec_size = 0;
+  }
+
+  /**
+   * Returns the element at the given index in the `StaticCircVector`.
+   *
+   * If the index is invalid, throws `out_of_range`.
+   */
+  constexpr T &at(size_t index) {
+    if (index >= this->vec_size) {
+      throw out_of_range("index is out of range");
+    }
+    return slot(index);
+  }
+
+  constexpr const T &at(size_t index) const {
+    if (index >= this->vec_size) {
+      throw out_of_range("index is out of range");
+    }
+    return slot(index);
+  }
+
+  /**
+   * Searches the `StaticCircVector` for the first matching element, and
+   * returns its index. If no match is found, returns "-1".
+   *
+   * At run time, scans the two contiguous runs of the ring with SIMD
+   * compares for arithmetic element types (see `simdscan.h`).
+   */
+  constexpr size_t find(const T &target) const {
+    if (!is_constant_evaluated()) {
+      auto [head, tail] = this->as_spans();
+      size_t idx = scan_find(head.data(), head.size(), target);
+      if (idx != head.size()) {
+        return idx;
+      }
+      idx = scan_find(tail.data(), tail.size(), target);
+      return idx != tail.size() ? head.size() + idx : -1;
+    }
+    for (size_t i = 0; i < this->vec_size; i++) {
+      if (slot(i) == target) {
+        return i;
+      }
+    }
+    return -1;
+  }
+
+  /**
+   * Returns whether any element is equal to `target`.
+   */
+  constexpr bool contains(const T &target) const {
+    return this->find(target) != static_cast<size_t>(-1);
+  }
+
+  /**
+   * Remove the element at the specified index. Shifts whichever side of the
+   * index is shorter, so it runs in O(min(index, N - index)) time.
+   *
+   * If the index is invalid, throws `out_of_range`.
+   */
+  constexpr void remove_at(size_t index) {
+    if (index >= this->vec_size) {
+      throw out_of_range("index is out of range");
+    }
+
+    if (index < this->vec_size - 1 - index) {
+      for (size_t i = index; i > 0; i--) {
+        slot(i) = move(slot(i - 1));
+      }
+      release(slot(0));
+      this->front_idx = wrap(this->front_idx, 1);
+    } else {
+      for (size_t i = index; i + 1 < this->vec_size; i++) {
+        slot(i) = move(slot(i + 1));
+      }
+      release(slot(this->vec_size - 1));
+    }
+    this->vec_size--;
+  }
+
+  /**
+   * Inserts the given `T` as a new element after the given index. Shifts
+   * whichever side of the index is shorter.
+   *
+   * If the index is invalid, throws `out_of_range`; if the
+   * `StaticCircVector` is full, throws `length_error`.
+   */
+  constexpr void insert_after(size_t index, T elem) {
+    if (index >= this->vec_size) {
+      throw out_of_range("index is out of range");
+    }
+    check_not_full();
+
+    size_t pos = index + 1;
+    if (pos < this->vec_size - pos) {
+      // Open the gap toward the front: [0, pos) moves back by one slot.
+      this->front_idx = wrap_back(this->front_idx);
+      for (size_t i = 0; i < pos; i++) {
+        slot(i) = move(slot(i + 1));
+      }
+    } else {
+      // Open the gap toward the back: [pos, size) moves up by one slot.
+      for (size_t i = this->vec_size; i > pos; i--) {
+        slot(i) = move(slot(i - 1));
+      }
+    }
+    this->vec_size++;
+    slot(pos) = move(elem);
+  }
+
+  /**
+   * Remove every other element (alternating) from the `StaticCircVector`,
+   * starting at index 1. Runs in O(N).
+   */
+  constexpr void remove_every_other() {
+    size_t kept = (this->vec_size + 1) / 2;
+    for (size_t i = 1; i < kept; i++) {
+      slot(i) = move(slot(2 * i));
+    }
+    for (size_t i = kept; i < this->vec_size; i++) {
+      release(slot(i));
+    }
+    this->vec_size = kept;
+  }
+
+  /**
+   * Returns the live elements as two contiguous runs, in logical order: the
+   * run from the front up to the end of the storage, then the run that
+   * wrapped around to the start of it.
+   */
+  constexpr pair<span<T>, span<T>> as_spans() {
+    size_t head = min(this->vec_size, N - this->front_idx);
+    return {span<T>(this->data + this->front_idx, head),
+            span<T>(this->data, this->vec_size - head)};
+  }
+
+  constexpr pair<span<const T>, span<const T>> as_spans() const {
+    size_t head = min(this->vec_size, N - this->front_idx);
+    return {span<const T>(this->data + this->front_idx, head),
+            span<const T>(this->data, this->vec_size - head)};
+  }
+
+  /**
+   * Converts the `StaticCircVector` to a string. Formatted like
+   * `[0, 1, 2, 3, 4]`.
+   */
+  string to_string() const {
+    stringstream oss;
+    oss << '[';
+    for (size_t i = 0; i < this->vec_size; i++) {
+      if (i != 0) {
+        oss << ", ";
+      }
+      oss << slot(i);
+    }
+    oss << ']';
+    return oss.str();
+  }
+
+  /**
+   * Whether both hold equal elements in the same order.
+   */
+  constexpr bool operator==(const StaticCircVector &other) const {
+    if (this->vec_size != other.vec_size) {
+      return false;
+    }
+    for (size_t i = 0; i < this->vec_size; i++) {
+      if (!(slot(i) == other.slot(i))) {
+        return false;
+      }
+    }
+    return true;
+  }
+};
@@ -0,0 +1,216 @@
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "staticcircvector.h"
+
+using namespace std;
+using namespace testing;
+
+// Compile-time checks: each builds a ring during constant evaluation.
+
+constexpr StaticCircVector<int, 4> wrapped_four() {
+  StaticCircVector<int, 4> vec;
+  vec.push_back(0);
+  vec.push_back(1);
+  vec.push_back(2);
+  vec.pop_front();
+  vec.pop_front();
+  vec.push_back(3);
+  vec.push_back(4);
+  vec.push_front(1);
+  return vec;  // [1, 2, 3, 4], wrapping around the end of the storage
+}
+
+static_assert(wrapped_four().size() == 4);
+static_assert(wrapped_four().full());
+static_assert(wrapped_four().at(0) == 1 && wrapped_four().at(3) == 4);
+static_assert(wrapped_four().find(3) == 2);
+static_assert(wrapped_four().find(9) == static_cast<size_t>(-1));
+static_assert(wrapped_four().as_spans().first.size() == 3);
+static_assert(wrapped_four().as_spans().second.size() == 1);
+static_assert(StaticCircVector<int, 4>::get_capacity() == 4);
+
+static_assert([] {
+  StaticCircVector<int, 5> vec;
+  for (int i = 0; i < 5; i++) {
+    vec.push_back(i);
+  }
+  vec.remove_every_other();
+  return vec.size() == 3 && vec.at(0) == 0 && vec.at(1) == 2 &&
+         vec.at(2) == 4;
+}());
+
+static_assert([] {
+  StaticCircVector<int, 4> vec = wrapped_four();
+  int back = vec.pop_back();
+  int front = vec.pop_front();
+  return back == 4 && front == 1 && vec.size() == 2;
+}());
+
+static_assert([] {
+  StaticCircVector<int, 8> vec;
+  vec.push_back(1);
+  vec.push_back(3);
+  vec.push_back(4);
+  vec.insert_after(0, 2);
+  vec.remove_at(3);
+  StaticCircVector<int, 8> expected;
+  expected.push_back(1);
+  expected.push_back(2);
+  expected.push_back(3);
+  return vec == expected;
+}());
+
+// Long strings allocate, so this checks that freed slots release their
+// memory before constant evaluation ends.
+constexpr bool strings_released() {
+  StaticCircVector<string, 3> vec;
+  vec.push_back("a rather long string that does not fit inline");
+  vec.push_front("b");
+  string popped = vec.pop_back();
+  vec.clear();
+  return popped.size() > 40 && vec.empty();
+}
+
+static_assert(strings_released());
+
+// Trivially copyable elements keep the ring trivially copyable.
+static_assert(is_trivially_copyable_v<StaticCircVector<int, 16>>);
+static_assert(sizeof(StaticCircVector<int, 16>) ==
+              16 * sizeof(int) + 2 * sizeof(size_t));
+
+// Runtime tests, mirroring circvector_tests.cpp.
+
+TEST(StaticCircVectorCore, empty) {
+  StaticCircVector<int, 4> vec;
+
+  EXPECT_THAT(vec.empty(), Eq(true));
+  EXPECT_THAT(vec.size(), Eq(0));
+}
+
+TEST(StaticCircVectorCore, push_pop) {
+  StaticCircVector<int, 4> vec;
+
+  vec.push_back(1);
+  vec.push_back(2);
+  vec.push_front(0);
+  EXPECT_THAT(vec.to_string(), StrEq("[0, 1, 2]"));
+  EXPECT_THAT(vec.pop_back(), Eq(2));
+  EXPECT_THAT(vec.pop_front(), Eq(0));
+  EXPECT_THAT(vec.size(), Eq(1));
+  EXPECT_THAT(vec.at(0), Eq(1));
+}
+
+TEST(StaticCircVectorCore, wrap) {
+  StaticCircVector<int, 3> vec;
+
+  for (int i = 0; i < 10; i++) {
+    vec.push_back(i);
+    if (vec.full()) {
+      vec.pop_front();
+    }
+  }
+  EXPECT_THAT(vec.to_string(), StrEq("[8, 9]"));
+  vec.push_front(7);
+  EXPECT_THAT(vec.to_string(), StrEq("[7, 8, 9]"));
+}
+
+TEST(StaticCircVectorCore, full_throws) {
+  StaticCircVector<int, 2> vec;
+
+  vec.push_back(1);
+  vec.push_back(2);
+  EXPECT_THROW(vec.push_back(3), length_error);
+  EXPECT_THROW(vec.push_front(0), length_error);
+  EXPECT_THROW(vec.insert_after(0, 5), length_error);
+  EXPECT_THAT(vec.to_string(), StrEq("[1, 2]"));
+}
+
+TEST(StaticCircVectorCore, empty_throws) {
+  StaticCircVector<int, 2> vec;
+
+  EXPECT_THROW(vec.pop_front(), runtime_error);
+  EXPECT_THROW(vec.pop_back(), runtime_error);
+  EXPECT_THROW(vec.at(0), out_of_range);
+}
+
+TEST(StaticCircVectorCore, clear) {
+  StaticCircVector<string, 4> vec;
+
+  vec.push_back("a");
+  vec.push_back("b");
+  vec.clear();
+  EXPECT_THAT(vec.empty(), Eq(true));
+  vec.push_back("c");
+  EXPECT_THAT(vec.to_string(), StrEq("[c]"));
+}
+
+TEST(StaticCircVectorAugmented, copy) {
+  StaticCircVector<string, 4> vec;
+  vec.push_back("x");
+  vec.push_back("y");
+
+  StaticCircVector<string, 4> copy = vec;
+  copy.push_back("z");
+  EXPECT_THAT(vec.to_string(), StrEq("[x, y]"));
+  EXPECT_THAT(copy.to_string(), StrEq("[x, y, z]"));
+  copy = vec;
+  EXPECT_THAT(copy == vec, Eq(true));
+}
+
+TEST(StaticCircVectorAugmented, find) {
+  StaticCircVector<int, 8> vec;
+  for (int i = 0; i < 6; i++) {
+    vec.push_back(i);
+  }
+  vec.pop_front();
+  vec.pop_front();
+  vec.push_back(6);
+  vec.push_back(7);
+  vec.push_back(8);  // wraps
+
+  EXPECT_THAT(vec.find(2), Eq(0));
+  EXPECT_THAT(vec.find(8), Eq(6));
+  EXPECT_THAT(vec.find(1), Eq(-1));
+  EXPECT_THAT(vec.contains(7), Eq(true));
+}
+
+TEST(StaticCircVectorAugmented, remove_at) {
+  StaticCircVector<int, 8> vec;
+  for (int i = 0; i < 6; i++) {
+    vec.push_back(i);
+  }
+
+  vec.remove_at(1);
+  vec.remove_at(3);
+  EXPECT_THAT(vec.to_string(), StrEq("[0, 2, 3, 5]"));
+  EXPECT_THROW(vec.remove_at(4), out_of_range);
+}
+
+TEST(StaticCircVectorExtras, insert_after) {
+  StaticCircVector<int, 8> vec;
+  vec.push_back(0);
+  vec.push_back(2);
+  vec.push_back(4);
+
+  vec.insert_after(0, 1);
+  vec.insert_after(2, 3);
+  vec.insert_after(4, 5);
+  EXPECT_THAT(vec.to_string(), StrEq("[0, 1, 2, 3, 4, 5]"));
+  EXPECT_THROW(vec.insert_after(6, 0), out_of_range);
+}
+
+TEST(StaticCircVectorExtras, remove_every_other) {
+  StaticCircVector<int, 8> vec;
+  for (int i = 0; i < 7; i++) {
+    vec.push_back(i);
+  }
+  vec.pop_front();
+  vec.push_back(7);
+  vec.push_back(8);
+
+  vec.remove_every_other();
+  EXPECT_THAT(vec.to_string(), StrEq("[1, 3, 5, 7]"));
+}
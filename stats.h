@@ -0,0 +1,251 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <sstream>
+#include <string>
+
+using namespace std;
+
+// Opt-in instrumentation for the containers. Each container takes a stats
+// policy as a template parameter: `NoStats` (the default) records nothing
+// and takes no space, while `ContainerStats` counts resizes, copied bytes,
+// node allocations and peak capacity, and keeps a latency histogram per
+// operation. A policy provides `time(op)`, which returns a guard that
+// records the time until it is destroyed, and the `on_*` hooks below.
+
+/**
+ * Operations whose latency `ContainerStats` records.
+ */
+enum class StatsOp {
+  push_front,
+  push_back,
+  pop_front,
+  pop_back,
+  at,
+  resize,
+};
+
+inline constexpr size_t stats_op_count = 6;
+
+inline constexpr const char *stats_op_names[stats_op_count] = {
+    "push_front", "push_back", "pop_front", "pop_back", "at", "resize",
+};
+
+/**
+ * Log-scale latency histogram. Bucket `i` counts samples of `[2^i, 2^(i+1))`
+ * nanoseconds; bucket 0 also counts samples under 1 ns.
+ */
+struct LatencyHistogram {
+  static constexpr size_t bucket_count = 40;
+
+  uint64_t buckets[bucket_count] = {};
+  uint64_t samples = 0;
+  uint64_t total_ns = 0;
+  uint64_t max_ns = 0;
+
+  void record(uint64_t ns) {
+    size_t bucket = ns == 0 ? 0 : bit_width(ns) - 1;
+    this->buckets[min(bucket, bucket_count - 1)]++;
+    this->samples++;
+    this->total_ns += ns;
+    this->max_ns = max(this->max_ns, ns);
+  }
+
+  /**
+   * Returns an upper bound on the `p`-th quantile (0 < p <= 1), in
+   * nanoseconds: the end of the bucket it falls in. Returns 0 if there are
+   * no samples.
+   */
+  uint64_t quantile(double p) const {
+    uint64_t rank = static_cast<uint64_t>(p * this->samples);
+    uint64_t seen = 0;
+    for (size_t i = 0; i < bucket_count; i++) {
+      seen += this->buckets[i];
+      if (seen > 0 && seen >= rank) {
+        return min(uint64_t(2) << i, this->max_ns);
+      }
+    }
+    return 0;
+  }
+};
+
+/**
+ * What a `ContainerStats` has recorded, as returned by `snapshot()`.
+ */
+struct StatsSnapshot {
+  uint64_t resizes = 0;           // Buffer reallocations, growing or not
+  uint64_t bytes_copied = 0;      // By resizes and by container copies
+  uint64_t node_allocations = 0;  // `LinkedList` nodes
+  uint64_t node_frees = 0;
+  uint64_t peak_capacity = 0;     // In elements
+  LatencyHistogram latency[stats_op_count];
+
+  const LatencyHistogram &operator[](StatsOp op) const {
+    return this->latency[static_cast<size_t>(op)];
+  }
+
+  /**
+   * Formats the counters, then a line per timed operation with its sample
+   * count, mean, p50/p99 upper bounds and max.
+   */
+  string to_string() const {
+    stringstream oss;
+    oss << "resizes " << this->resizes << '\n'
+        << "bytes_copied " << this->bytes_copied << '\n'
+        << "node_allocations " << this->node_allocations << '\n'
+        << "node_frees " << this->node_frees << '\n'
+        << "peak_capacity " << this->peak_capacity << '\n';
+    for (size_t i = 0; i < stats_op_count; i++) {
+      const LatencyHistogram &hist = this->latency[i];
+      if (hist.samples == 0) {
+        continue;
+      }
+      oss << stats_op_names[i] << ": " << hist.samples << " calls, mean "
+          << hist.total_ns / hist.samples << " ns, p50 <= "
+          << hist.quantile(0.5) << " ns, p99 <= " << hist.quantile(0.99)
+          << " ns, max " << hist.max_ns << " ns\n";
+    }
+    return oss.str();
+  }
+
+  /**
+   * Formats everything as a JSON object. Each operation lists its non-empty
+   * buckets as `[lower bound in ns, count]` pairs.
+   */
+  string to_json() const {
+    stringstream oss;
+    oss << "{\"resizes\":" << this->resizes
+        << ",\"bytes_copied\":" << this->bytes_copied
+        << ",\"node_allocations\":" << this->node_allocations
+        << ",\"node_frees\":" << this->node_frees
+        << ",\"peak_capacity\":" << this->peak_capacity << ",\"latency\":{";
+    for (size_t i = 0; i < stats_op_count; i++) {
+      const LatencyHistogram &hist = this->latency[i];
+      oss << (i == 0 ? "" : ",") << '"' << stats_op_names[i]
+          << "\":{\"samples\":" << hist.samples
+          << ",\"total_ns\":" << hist.total_ns
+          << ",\"max_ns\":" << hist.max_ns << ",\"buckets\":[";
+      bool first = true;
+      for (size_t b = 0; b < LatencyHistogram::bucket_count; b++) {
+        if (hist.buckets[b] != 0) {
+          oss << (first ? "" : ",") << '[' << (b == 0 ? 0 : uint64_t(1) << b)
+              << ',' << hist.buckets[b] << ']';
+          first = false;
+        }
+      }
+      oss << "]}";
+    }
+    oss << "}}";
+    return oss.str();
+  }
+};
+
+/**
+ * Stats policy that records nothing. Every hook is empty, so the compiler
+ * drops the calls, and `[[no_unique_address]]` drops the member.
+ */
+struct NoStats {
+  static constexpr bool enabled = false;
+
+  struct Timer {};
+
+  Timer time(StatsOp) {
+    return {};
+  }
+
+  void on_resize(size_t) {
+  }
+
+  void on_copy(size_t) {
+  }
+
+  void on_node_allocation() {
+  }
+
+  void on_node_free() {
+  }
+
+  void on_capacity(size_t) {
+  }
+};
+
+/**
+ * Stats policy that records counters and latency histograms. Not
+ * synchronized: it shares the thread-safety of the container it is in.
+ */
+class ContainerStats {
+ private:
+  StatsSnapshot current;
+
+ public:
+  static constexpr bool enabled = true;
+
+  // Records the time from its construction to its destruction.
+  class Timer {
+   private:
+    LatencyHistogram *hist;
+    chrono::steady_clock::time_point start;
+
+   public:
+    explicit Timer(LatencyHistogram *hist)
+        : hist(hist), start(chrono::steady_clock::now()) {
+    }
+
+    Timer(const Timer &) = delete;
+    Timer &operator=(const Timer &) = delete;
+
+    ~Timer() {
+      auto elapsed = chrono::steady_clock::now() - this->start;
+      this->hist->record(
+          chrono::duration_cast<chrono::nanoseconds>(elapsed).count());
+    }
+  };
+
+  Timer time(StatsOp op) {
+    return Timer(&this->current.latency[static_cast<size_t>(op)]);
+  }
+
+  // A buffer reallocation that moved `bytes` of elements.
+  void on_resize(size_t bytes) {
+    this->current.resizes++;
+    this->current.bytes_copied += bytes;
+  }
+
+  // A container copy that copied `bytes` of elements.
+  void on_copy(size_t bytes) {
+    this->current.bytes_copied += bytes;
+  }
+
+  void on_node_allocation() {
+    this->current.node_allocations++;
+  }
+
+  void on_node_free() {
+    this->current.node_frees++;
+  }
+
+  // The container now has room for `capacity` elements.
+  void on_capacity(size_t capacity) {
+    this->current.peak_capacity =
+        max<uint64_t>(this->current.peak_capacity, capacity);
+  }
+
+  /**
+   * Returns a copy of everything recorded since construction or the last
+   * `reset()`.
+   */
+  StatsSnapshot snapshot() const {
+    return this->current;
+  }
+
+  /**
+   * Forgets everything recorded so far.
+   */
+  void reset() {
+    this->current = StatsSnapshot();
+  }
+};
@@ -0,0 +1,221 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <type_traits>
+
+#include "circvector.h"
+#include "concurrency.h"
+
+using namespace std;
+
+/**
+ * Chase-Lev work-stealing deque. Like `CircVector`, a growable ring
+ * addressed through a capacity policy, with one end per kind of user: the
+ * owning thread pushes and pops at the back (LIFO, so it works on what it
+ * queued last, which is still in cache), and any number of thieves steal
+ * from the front (FIFO, so they take the oldest, usually largest, work).
+ * Follows the C11 formulation of Lê, Pop, Cohen and Zappa Nardelli,
+ * "Correct and Efficient Work-Stealing for Weak Memory Models" (PPoPP 2013).
+ *
+ * `top` and `bottom` count steals and pushes since construction, so the
+ * elements are positions `[top, bottom)`. The owner alone moves `bottom`;
+ * thieves claim `top` with a CAS, and so does the owner when it pops the
+ * last element, so exactly one of them gets it. Nothing takes a lock.
+ *
+ * A full ring grows: the owner copies the live positions into a ring twice
+ * the size and publishes it. Thieves that loaded the old ring still read
+ * valid values from it, since the owner never writes to a ring once it is
+ * replaced, and their CAS on `top` decides whether the value is theirs. So
+ * the old ring is only retired, and freed with the deque. Capacities
+ * double, so retired rings add up to less than the current one.
+ *
+ * Thieves read a slot before they know whether they won it, possibly while
+ * the owner overwrites it, so slots are atomics and `T` must be trivially
+ * copyable: queue pointers or indices to larger work items.
+ */
+template <typename T, typename CapacityPolicy = PowerOfTwoCapacity>
+class WorkStealingDeque {
+  static_assert(is_trivially_copyable_v<T>,
+                "thieves read slots racily; store pointers or indices to "
+                "work items that are not trivially copyable");
+  static_assert(atomic<T>::is_always_lock_free,
+                "slots must be lock-free atomics; store pointers or indices "
+                "to larger work items");
+
+ private:
+  struct Ring {
+    size_t capacity;
+    unique_ptr<atomic<T>[]> slots;
+
+    explicit Ring(size_t capacity)
+        : capacity(capacity), slots(make_unique<atomic<T>[]>(capacity)) {
+    }
+
+    atomic<T> &slot(int64_t pos) const {
+      return this->slots[CapacityPolicy::wrap(static_cast<size_t>(pos),
+                                              this->capacity)];
+    }
+  };
+
+  // Stolen from; claimed by CAS. Thieves and the owner both write it.
+  alignas(cache_line_size) atomic<int64_t> top;
+
+  // Pushed to and popped from by the owner only.
+  alignas(cache_line_size) atomic<int64_t> bottom;
+  atomic<Ring *> ring;
+
+  // Replaced rings, which thieves may still be reading. Owner only.
+  CircVector<Ring *> retired;
+
+  // Copies positions `[t, b)` into a ring twice the size, publishes it and
+  // retires `old`. Owner only.
+  Ring *grow(Ring *old, int64_t t, int64_t b) {
+    // Owned here until published, so a failed `push_back` frees it.
+    auto bigger = make_unique<Ring>(CapacityPolicy::round(old->capacity * 2));
+    for (int64_t pos = t; pos < b; pos++) {
+      bigger->slot(pos).store(old->slot(pos).load(memory_order_relaxed),
+                              memory_order_relaxed);
+    }
+    this->retired.push_back(old);
+    this->ring.store(bigger.get(), memory_order_release);
+    return bigger.release();
+  }
+
+ public:
+  /**
+   * Creates an empty deque with room for `capacity` elements, rounded up
+   * by the capacity policy, before it grows. Capacity must exceed 0.
+   */
+  explicit WorkStealingDeque(size_t capacity = 64) {
+    if (capacity == 0) {
+      throw out_of_range("invalid capacity. must exceed zero");
+    }
+
+    this->top.store(0, memory_order_relaxed);
+    this->bottom.store(0, memory_order_relaxed);
+    this->ring.store(new Ring(CapacityPolicy::round(capacity)),
+                     memory_order_relaxed);
+  }
+
+  WorkStealingDeque(const WorkStealingDeque &) = delete;
+  WorkStealingDeque &operator=(const WorkStealingDeque &) = delete;
+
+  /**
+   * Destructor. Frees the ring and every retired one. No other thread may
+   * be using the deque.
+   */
+  ~WorkStealingDeque() {
+    delete this->ring.load(memory_order_relaxed);
+    while (!this->retired.empty()) {
+      delete this->retired.pop_back();
+    }
+  }
+
+  /**
+   * Owner only. Adds the given `T` to the back, growing the ring if it is
+   * full.
+   */
+  void push_back(T elem) {
+    int64_t b = this->bottom.load(memory_order_relaxed);
+    int64_t t = this->top.load(memory_order_acquire);
+    Ring *current = this->ring.load(memory_order_relaxed);
+    if (b - t >= static_cast<int64_t>(current->capacity)) {
+      current = grow(current, t, b);
+    }
+
+    current->slot(b).store(elem, memory_order_relaxed);
+    // Thieves that see the new `bottom` see the element too.
+    atomic_thread_fence(memory_order_release);
+    this->bottom.store(b + 1, memory_order_relaxed);
+  }
+
+  /**
+   * Owner only. Removes the element at the back and returns it, or returns
+   * an empty `optional` if the deque is empty or a thief took the last
+   * element first.
+   */
+  optional<T> try_pop_back() {
+    int64_t b = this->bottom.load(memory_order_relaxed) - 1;
+    Ring *current = this->ring.load(memory_order_relaxed);
+    // Reserve position `b` before looking at `top`; the fence orders the
+    // two against the opposite order in `steal()`.
+    this->bottom.store(b, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    int64_t t = this->top.load(memory_order_relaxed);
+
+    if (t > b) {
+      // Empty.
+      this->bottom.store(b + 1, memory_order_relaxed);
+      return nullopt;
+    }
+
+    T elem = current->slot(b).load(memory_order_relaxed);
+    if (t < b) {
+      // More than one element: thieves stop short of `b`.
+      return elem;
+    }
+
+    // The last element: race the thieves for it.
+    bool won = this->top.compare_exchange_strong(
+        t, t + 1, memory_order_seq_cst, memory_order_relaxed);
+    this->bottom.store(b + 1, memory_order_relaxed);
+    if (!won) {
+      return nullopt;
+    }
+    return elem;
+  }
+
+  /**
+   * Any thread. Removes the element at the front and returns it, or
+   * returns an empty `optional` if the deque looked empty or another thread
+   * claimed the element first. Callers that need work should try again or
+   * move on to another deque.
+   */
+  optional<T> steal() {
+    int64_t t = this->top.load(memory_order_acquire);
+    atomic_thread_fence(memory_order_seq_cst);
+    int64_t b = this->bottom.load(memory_order_acquire);
+    if (t >= b) {
+      return nullopt;
+    }
+
+    // Read before claiming: once `top` moves past `t`, the owner may reuse
+    // the slot.
+    Ring *current = this->ring.load(memory_order_acquire);
+    T elem = current->slot(t).load(memory_order_relaxed);
+    if (!this->top.compare_exchange_strong(t, t + 1, memory_order_seq_cst,
+                                           memory_order_relaxed)) {
+      return nullopt;
+    }
+    return elem;
+  }
+
+  /**
+   * Returns the number of elements. Only a snapshot while other threads are
+   * running.
+   */
+  size_t size() const {
+    int64_t t = this->top.load(memory_order_acquire);
+    int64_t b = this->bottom.load(memory_order_acquire);
+    return b > t ? static_cast<size_t>(b - t) : 0;
+  }
+
+  /**
+   * Returns whether the deque is empty. Only a snapshot while other threads
+   * are running.
+   */
+  bool empty() const {
+    return this->size() == 0;
+  }
+
+  /**
+   * Returns how many elements fit before the ring next grows.
+   */
+  size_t get_capacity() const {
+    return this->ring.load(memory_order_acquire)->capacity;
+  }
+};
@@ -0,0 +1,151 @@
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "workstealingdeque.h"
+
+using namespace std;
+using namespace testing;
+
+TEST(WorkStealingDequeCore, owner_lifo_thief_fifo) {
+  WorkStealingDeque<int> deque(4);
+
+  deque.push_back(1);
+  deque.push_back(2);
+  deque.push_back(3);
+  EXPECT_THAT(deque.size(), Eq(3));
+  EXPECT_THAT(deque.try_pop_back(), Optional(3));
+  EXPECT_THAT(deque.steal(), Optional(1));
+  EXPECT_THAT(deque.try_pop_back(), Optional(2));
+  EXPECT_THAT(deque.empty(), Eq(true));
+}
+
+TEST(WorkStealingDequeCore, empty_returns_nothing) {
+  WorkStealingDeque<int> deque;
+
+  EXPECT_THAT(deque.try_pop_back(), Eq(nullopt));
+  EXPECT_THAT(deque.steal(), Eq(nullopt));
+  deque.push_back(1);
+  EXPECT_THAT(deque.steal(), Optional(1));
+  EXPECT_THAT(deque.try_pop_back(), Eq(nullopt));
+  EXPECT_THAT(deque.size(), Eq(0));
+}
+
+TEST(WorkStealingDequeCore, zero_capacity_throws) {
+  EXPECT_THROW(WorkStealingDeque<int>(0), out_of_range);
+}
+
+TEST(WorkStealingDequeCore, grows_keeping_order) {
+  WorkStealingDeque<int> deque(3);  // rounded up to 4
+
+  EXPECT_THAT(deque.get_capacity(), Eq(4));
+  deque.push_back(0);
+  deque.push_back(1);
+  deque.steal();
+  deque.steal();  // the live positions now wrap around the ring
+  for (int i = 2; i < 100; i++) {
+    deque.push_back(i);
+  }
+  EXPECT_THAT(deque.get_capacity(), Eq(128));
+  EXPECT_THAT(deque.try_pop_back(), Optional(99));
+  for (int i = 2; i < 99; i++) {
+    ASSERT_THAT(deque.steal(), Optional(i));
+  }
+  EXPECT_THAT(deque.empty(), Eq(true));
+}
+
+TEST(WorkStealingDequeCore, exact_capacity) {
+  WorkStealingDeque<int, ExactCapacity> deque(3);
+
+  for (int i = 0; i < 10; i++) {
+    deque.push_back(i);
+  }
+  EXPECT_THAT(deque.get_capacity(), Eq(12));
+  for (int i = 0; i < 10; i++) {
+    ASSERT_THAT(deque.steal(), Optional(i));
+  }
+}
+
+// Runs the owner against `thieves` stealing threads and checks that every
+// index from 0 to `total` was taken exactly once. `owner(deque, take)` pushes
+// every index and takes some back itself through `take`; it returns once
+// the deque is empty.
+template <typename Owner>
+void expect_each_taken_once(size_t total, size_t thieves, Owner owner) {
+  WorkStealingDeque<uint32_t> deque(2);  // grows while thieves read
+  vector<atomic<uint32_t>> taken(total);
+  atomic<bool> done(false);
+  auto take = [&taken](uint32_t index) {
+    taken[index].fetch_add(1, memory_order_relaxed);
+  };
+
+  vector<thread> workers;
+  for (size_t i = 0; i < thieves; i++) {
+    workers.emplace_back([&deque, &done, &take] {
+      while (!done.load(memory_order_acquire) || !deque.empty()) {
+        if (optional<uint32_t> elem = deque.steal()) {
+          take(*elem);
+        } else {
+          this_thread::yield();
+        }
+      }
+    });
+  }
+  owner(deque, take);
+  done.store(true, memory_order_release);
+  for (thread &worker : workers) {
+    worker.join();
+  }
+
+  size_t lost = 0;
+  size_t duplicated = 0;
+  for (const atomic<uint32_t> &count : taken) {
+    lost += count.load() == 0;
+    duplicated += count.load() > 1;
+  }
+  EXPECT_THAT(lost, Eq(0));
+  EXPECT_THAT(duplicated, Eq(0));
+}
+
+// Bursts of pushes with some pops in between, so the ring grows and wraps
+// while thieves are stealing from it.
+TEST(WorkStealingDequeThreads, no_loss_or_duplication) {
+  const size_t total = 1 << 18;
+
+  expect_each_taken_once(total, 4, [total](auto &deque, auto &take) {
+    for (uint32_t i = 0; i < total; i++) {
+      deque.push_back(i);
+      if (i % 3 == 0) {
+        if (optional<uint32_t> elem = deque.try_pop_back()) {
+          take(*elem);
+        }
+      }
+    }
+    while (!deque.empty()) {
+      if (optional<uint32_t> elem = deque.try_pop_back()) {
+        take(*elem);
+      }
+    }
+  });
+}
+
+// One element at a time, so the owner's pop and the thieves' steals race
+// for the last element on every round.
+TEST(WorkStealingDequeThreads, last_element_race) {
+  const size_t total = 1 << 17;
+
+  expect_each_taken_once(total, 4, [total](auto &deque, auto &take) {
+    for (uint32_t i = 0; i < total; i++) {
+      deque.push_back(i);
+      if (optional<uint32_t> elem = deque.try_pop_back()) {
+        take(*elem);
+      }
+    }
+  });
+}